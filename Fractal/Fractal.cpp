@@ -5,143 +5,3704 @@
 #if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
 #include <sycl/ext/intel/fpga_extensions.hpp>
 #endif
+#if _WIN32
+#include <fcntl.h>
+#include <io.h>
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <csignal>
+#endif
+
+#include <vector>
+#include <complex>
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <future>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <array>
+#include <utility>
+#include <type_traits>
+#include <limits>
+#include <mutex>
+#include <condition_variable>
+#include <iomanip>
+#include <cstring>
+#include <cctype>
+#include <cmath>
+#include <cerrno>
+
+using namespace std::literals::complex_literals;
+typedef std::complex<float> complex;
+
+constexpr size_t WIDTH = 1024, HEIGHT = 768;
+constexpr size_t ITERATION_COUNT = 20;
+constexpr uint8_t FILL_INTENSITY = 255;
+constexpr uint8_t MIN_INTENSITY = 64;
+constexpr float ROOT_TOLERANCE = 1e-6f;
+constexpr float STEP_EPSILON = 1e-10f;
+constexpr size_t PROGRESSIVE_BLOCK = 4, PROGRESSIVE_MAX_BLOCK = 8;
+constexpr uint32_t PASS_BUDGET_MS = 16;
+constexpr double PAN_PIXELS_PER_SECOND = 600.0, ZOOM_LEVELS_PER_SECOND = 60.0, MAX_FRAME_SECONDS = 0.05;
+constexpr int BUSY_WAIT_MS = 1, IDLE_WAIT_MS = 250;
+constexpr double UNIT_WIDTH = 10.0, ZOOM_STEP = 0.95;
+constexpr size_t TILE_SIZE = 64;
+constexpr size_t TILE_CACHE_SLOTS = 1024;
+constexpr uint32_t BOUNDARY_TILE = 64, BOUNDARY_MIN_TILE = 4;
+constexpr size_t MIN_ROOTS = 3, MAX_ROOTS = 8;
+constexpr int FLOAT_ZOOM_BITS = 18;
+constexpr size_t BENCHMARK_FRAMES = 10;
+constexpr size_t VERIFY_WIDTH = 256, VERIFY_HEIGHT = 192;
+constexpr double VERIFY_PAN_PIXELS = 13.0;
+constexpr size_t VERIFY_DRAG_PIXELS = 2;
+constexpr int SIMD_LANES = 8;
+constexpr size_t GOVERNOR_MIN_ITERATIONS = 4;
+constexpr size_t STAGE_COUNT = 4, PROFILE_HISTORY = 240;
+constexpr int OVERLAY_MARGIN = 10;
+constexpr float OVERLAY_BAR_WIDTH = 2.0f, OVERLAY_PIXELS_PER_MS = 4.0f;
+constexpr size_t PALETTE_SIZE = 32;
+constexpr float PALETTE_BAND_ITERATIONS = 4.0f;
+constexpr uint32_t COUNT_FRACTION_BITS = 8;
+constexpr uint32_t ADAPTIVE_SIDE = 4, ANTIALIAS_CONTRAST = 24;
+constexpr size_t SWEEP_BATCH = 8;
+constexpr size_t POSTER_BAND_PIXELS = size_t(1) << 24;
+constexpr uint32_t WARM_STEPS = 4;
+constexpr uint32_t FPGA_NEWTON_DEPTH = 32;
+constexpr int FPGA_PIPE_DEPTH = 64;
+constexpr size_t FPGA_ROOT_COUNT = 3;
+// Interactive limit; the pipelined stages take at most FPGA_NEWTON_DEPTH iterations.
+#if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
+constexpr size_t MAX_ITERATION_COUNT = FPGA_NEWTON_DEPTH;
+#else
+constexpr size_t MAX_ITERATION_COUNT = std::numeric_limits<size_t>::max();
+#endif
+constexpr double WARM_DRIFT_PIXELS = 8.0;
+constexpr uint32_t WARM_IDLE_MS = 150;
+constexpr size_t SERVE_TILE = 256;
+constexpr size_t SERVE_CACHE_BYTES = size_t(256) << 20;
+constexpr int SERVE_MAX_ZOOM = 40;
+constexpr size_t SERVE_MAX_ITERATIONS = 4096, SERVE_MAX_REQUEST = 16384;
+constexpr int SERVE_BACKLOG = 64;
+constexpr size_t SERVE_WORKERS = 16, SERVE_MAX_QUEUED = 256;
+constexpr int SERVE_TIMEOUT_MS = 5000, SERVE_ACCEPT_BACKOFF_MS = 100;
+
+#if _WIN32
+typedef SOCKET socket_t;
+#else
+typedef int socket_t;
+constexpr socket_t INVALID_SOCKET = -1;
+
+static int closesocket(const socket_t s) {
+    return close(s);
+}
+#endif
+
+static int socket_error() {
+#if _WIN32
+    return WSAGetLastError();
+#else
+    return errno;
+#endif
+}
+
+static auto exception_handler = [](sycl::exception_list e_list) {
+    for (std::exception_ptr const& e : e_list) {
+        try {
+            std::rethrow_exception(e);
+        }
+        catch (std::exception const& e) {
+#if _DEBUG
+            std::cout << "Failure" << std::endl;
+#endif
+            std::terminate();
+        }
+    }
+    };
+
+enum class Engine {
+    Fused,
+    MultiPass,
+    Tiled,
+    Simd,
+    Boundary,
+    Pipelined,
+};
+
+static const char* engine_name(const Engine engine) {
+    switch (engine) {
+    case Engine::Fused:
+        return "fused";
+    case Engine::MultiPass:
+        return "multi-pass";
+    case Engine::Tiled:
+        return "tiled";
+    case Engine::Simd:
+        return "simd";
+    case Engine::Boundary:
+        return "boundary";
+    case Engine::Pipelined:
+        return "pipelined";
+    }
+    return "unknown";
+}
+
+enum class Precision {
+    Half,
+    Float,
+    Double,
+    DoubleFloat,
+};
+
+static const char* precision_name(const Precision precision) {
+    switch (precision) {
+    case Precision::Half:
+        return "half";
+    case Precision::Float:
+        return "float";
+    case Precision::Double:
+        return "double";
+    case Precision::DoubleFloat:
+        return "double-float";
+    }
+    return "unknown";
+}
+
+static bool precision_supported(const sycl::device& device, const Precision precision) {
+    switch (precision) {
+    case Precision::Half:
+        return device.has(sycl::aspect::fp16);
+    case Precision::Double:
+        return device.has(sycl::aspect::fp64);
+    default:
+        return true;
+    }
+}
+
+// How converged samples are coloured. Classic shades each root's colour by whole iterations; the next three
+// interpolate the fractional iteration count at which the sample reached the root tolerance. Index is for
+// checking images rather than looking at them: red holds the root index and green the iteration count.
+enum class Palette {
+    Classic,
+    Smooth,
+    Pastel,
+    Bands,
+    Index,
+};
+
+static const char* palette_name(const Palette palette) {
+    switch (palette) {
+    case Palette::Classic:
+        return "classic";
+    case Palette::Smooth:
+        return "smooth";
+    case Palette::Pastel:
+        return "pastel";
+    case Palette::Bands:
+        return "bands";
+    case Palette::Index:
+        return "index";
+    }
+    return "unknown";
+}
+
+// Supersampling: off, a regular grid of samples in every pixel, or jittered ADAPTIVE_SIDE x ADAPTIVE_SIDE
+// samples in pixels whose colour differs from a neighbour's by more than ANTIALIAS_CONTRAST.
+enum class Antialias {
+    Off,
+    Grid2,
+    Grid3,
+    Grid4,
+    Adaptive,
+};
+
+static const char* antialias_name(const Antialias antialias) {
+    switch (antialias) {
+    case Antialias::Off:
+        return "off";
+    case Antialias::Grid2:
+        return "2x2";
+    case Antialias::Grid3:
+        return "3x3";
+    case Antialias::Grid4:
+        return "4x4";
+    case Antialias::Adaptive:
+        return "adaptive";
+    }
+    return "unknown";
+}
+
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+// Samples per pixel side in the first pass; the adaptive mode starts from one.
+static uint32_t antialias_side(const Antialias antialias) {
+    switch (antialias) {
+    case Antialias::Grid2:
+        return 2;
+    case Antialias::Grid3:
+        return 3;
+    case Antialias::Grid4:
+        return 4;
+    default:
+        return 1;
+    }
+}
+#endif
+
+// The precision kernels actually run at: half falls back to float and double to its float-float emulation.
+static Precision supported_precision(const sycl::device& device, const Precision precision) {
+    if (precision_supported(device, precision)) return precision;
+    return precision == Precision::Double ? Precision::DoubleFloat : Precision::Float;
+}
+
+struct View {
+    complex roots[MAX_ROOTS];
+    size_t root_count;
+    double unit, left, top;
+    size_t iterations;
+    Precision precision;
+    Palette palette;
+    Antialias antialias;
+};
+
+static View make_view(
+    const complex* roots, const size_t root_count,
+    const double unit, const double left, const double top,
+    const size_t iterations, const Precision precision
+) {
+    View view{};
+    std::copy(roots, roots + root_count, view.roots);
+    view.root_count = root_count;
+    view.unit = unit;
+    view.left = left;
+    view.top = top;
+    view.iterations = iterations;
+    view.precision = precision;
+    return view;
+}
+
+static bool same_roots(const View& x, const View& y) {
+    return x.root_count == y.root_count && std::equal(x.roots, x.roots + x.root_count, y.roots);
+}
+
+// Cheapest precision that still separates neighbouring pixels of a w x h frame. Float is used while the
+// coordinates need fewer than FLOAT_ZOOM_BITS of its 24 bits, leaving the rest for the iteration itself;
+// deeper views use double where the device has it and double-float otherwise.
+static Precision precision_for_zoom(const sycl::device& device, const View& view, const size_t w, const size_t h) {
+    const double span = std::max({ 1.0, std::abs(view.left), std::abs(view.left + view.unit * w),
+        std::abs(view.top), std::abs(view.top - view.unit * h) });
+    if (span / view.unit < std::ldexp(1.0, FLOAT_ZOOM_BITS)) return Precision::Float;
+    return precision_supported(device, Precision::Double) ? Precision::Double : Precision::DoubleFloat;
+}
+
+// Unevaluated sum hi + lo of two floats, giving about 48 significant bits on devices without fp64. The error-free
+// transforms below rely on value-safe float arithmetic, so contraction and reassociation are disabled around them.
+#pragma float_control(precise, on, push)
+struct DoubleFloat {
+    float hi, lo;
+
+    DoubleFloat() = default;
+    DoubleFloat(const float x) : hi(x), lo(0.0f) {}
+    DoubleFloat(const float h, const float l) : hi(h), lo(l) {}
+    // Host-side conversion; kernels only ever receive already-split values.
+    explicit DoubleFloat(const double x) : hi(static_cast<float>(x)), lo(static_cast<float>(x - static_cast<float>(x))) {}
+    template <typename I, typename = std::enable_if_t<std::is_integral_v<I>>>
+    explicit DoubleFloat(const I x) {
+        const int64_t i = static_cast<int64_t>(x);
+        hi = static_cast<float>(i);
+        lo = static_cast<float>(i - static_cast<int64_t>(hi));
+    }
+};
+
+// Double-float arithmetic is only used by the engines that FPGA builds leave out.
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+static DoubleFloat quick_two_sum(const float a, const float b) {
+    const float s = a + b;
+    return DoubleFloat(s, b - (s - a));
+}
+
+static DoubleFloat two_sum(const float a, const float b) {
+    const float s = a + b;
+    const float bb = s - a;
+    return DoubleFloat(s, (a - (s - bb)) + (b - bb));
+}
+
+static DoubleFloat operator+(const DoubleFloat x, const DoubleFloat y) {
+    const DoubleFloat s = two_sum(x.hi, y.hi);
+    return quick_two_sum(s.hi, s.lo + x.lo + y.lo);
+}
+
+static DoubleFloat operator-(const DoubleFloat x) {
+    return DoubleFloat(-x.hi, -x.lo);
+}
+
+static DoubleFloat operator-(const DoubleFloat x, const DoubleFloat y) {
+    return x + -y;
+}
+
+static DoubleFloat operator*(const DoubleFloat x, const DoubleFloat y) {
+    const float p = x.hi * y.hi;
+    const float e = sycl::fma(x.hi, y.hi, -p);
+    return quick_two_sum(p, e + (x.hi * y.lo + x.lo * y.hi));
+}
+
+static DoubleFloat operator/(const DoubleFloat x, const DoubleFloat y) {
+    const float q1 = x.hi / y.hi;
+    const DoubleFloat r = x - y * DoubleFloat(q1);
+    return quick_two_sum(q1, r.hi / y.hi);
+}
+
+static bool operator<(const DoubleFloat x, const DoubleFloat y) {
+    return x.hi < y.hi || (x.hi == y.hi && x.lo < y.lo);
+}
+#endif
+#pragma float_control(pop)
+
+// Minimal complex type for kernels; std::complex is only specified for float, double and long double.
+template <typename T>
+struct Complex {
+    T re, im;
+};
+
+template <typename T>
+static Complex<T> operator+(const Complex<T> x, const Complex<T> y) {
+    return Complex<T>{ x.re + y.re, x.im + y.im };
+}
+
+template <typename T>
+static Complex<T> operator-(const Complex<T> x, const Complex<T> y) {
+    return Complex<T>{ x.re - y.re, x.im - y.im };
+}
+
+template <typename T>
+static Complex<T> operator*(const Complex<T> x, const Complex<T> y) {
+    return Complex<T>{ x.re * y.re - x.im * y.im, x.re * y.im + x.im * y.re };
+}
+
+template <typename T>
+static Complex<T> operator/(const Complex<T> x, const Complex<T> y) {
+    const T d = y.re * y.re + y.im * y.im;
+    return Complex<T>{ (x.re * y.re + x.im * y.im) / d, (x.im * y.re - x.re * y.im) / d };
+}
+
+template <typename T>
+static T norm2(const Complex<T> x) {
+    return x.re * x.re + x.im * x.im;
+}
+
+template <typename T>
+static float to_float(const T x) {
+    return static_cast<float>(x);
+}
+
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+static float to_float(const DoubleFloat x) {
+    return x.hi + x.lo;
+}
+#endif
+
+// Pixel coordinates are computed in the kernel's scalar type, except for half, which cannot address a frame's
+// worth of pixels and uses float.
+template <typename T>
+using Coord = std::conditional_t<std::is_same_v<T, sycl::half>, float, T>;
+
+template <typename T>
+static Complex<T> to_complex(const Coord<T> re, const Coord<T> im) {
+    return Complex<T>{ static_cast<T>(re), static_cast<T>(im) };
+}
+
+// Squared distance to a root below which a pixel counts as converged, and squared step below which it stalled.
+template <typename T>
+struct Tolerance;
+
+template <>
+struct Tolerance<sycl::half> {
+    static constexpr float root = 1e-3f, step = 1e-6f;
+};
+
+template <>
+struct Tolerance<float> {
+    static constexpr float root = ROOT_TOLERANCE, step = STEP_EPSILON;
+};
+
+template <>
+struct Tolerance<double> {
+    static constexpr double root = 1e-12, step = 1e-24;
+};
+
+template <>
+struct Tolerance<DoubleFloat> {
+    static constexpr float root = 1e-12f, step = 1e-24f;
+};
+
+template <typename F, size_t... I>
+static void unroll(F&& f, std::index_sequence<I...>) {
+    (f(std::integral_constant<size_t, I>()), ...);
+}
+
+// Calls f(integral_constant<0>) ... f(integral_constant<N - 1>) as straight-line code.
+template <size_t N, typename F>
+static void unroll(F&& f) {
+    unroll(f, std::make_index_sequence<N>());
+}
+
+// Per-frame descriptor of the monic polynomial with the given N roots, p(x) = x^N + coeffs[N - 1] x^(N - 1) +
+// ... + coeffs[0], built once on the host; kernels capture it by value, which keeps it in constant memory.
+// isolation[k] is the squared half-distance from root k to its nearest neighbour: no other root can be nearer
+// to a point that close to root k.
+template <size_t N, typename T>
+struct Polynomial {
+    Complex<T> coeffs[N];
+    Complex<T> roots[N];
+    T isolation[N];
+};
+
+template <size_t N, typename T>
+static Polynomial<N, T> make_polynomial(const View& view) {
+    std::complex<double> c[N + 1] = { 1.0 };
+    for (size_t r = 0; r < N; ++r) {
+        const std::complex<double> root = view.roots[r];
+        for (size_t k = r + 1; k > 0; --k) c[k] = c[k - 1] - root * c[k];
+        c[0] = -root * c[0];
+    }
+    Polynomial<N, T> p;
+    for (size_t k = 0; k < N; ++k) {
+        p.coeffs[k] = to_complex<T>(static_cast<Coord<T>>(c[k].real()), static_cast<Coord<T>>(c[k].imag()));
+        p.roots[k] = to_complex<T>(static_cast<Coord<T>>(view.roots[k].real()), static_cast<Coord<T>>(view.roots[k].imag()));
+        double nearest = std::numeric_limits<double>::max();
+        for (size_t j = 0; j < N; ++j)
+            if (j != k) nearest = std::min(nearest, std::norm(std::complex<double>(view.roots[j]) - std::complex<double>(view.roots[k])));
+        // Capped so that half can hold it; a smaller radius only means more full scans.
+        p.isolation[k] = T(static_cast<Coord<T>>(std::min(nearest / 4.0, 1e4)));
+    }
+    return p;
+}
+
+// One Newton step, evaluating p and p' together with an unrolled Horner scheme.
+template <size_t N, typename T>
+static Complex<T> newton_step(const Complex<T> x, const Polynomial<N, T>& p) {
+    Complex<T> v{ T(1), T(0) }, d{ T(0), T(0) };
+    unroll<N>([&](auto i) {
+        constexpr size_t k = N - 1 - decltype(i)::value;
+        d = d * x + v;
+        v = v * x + p.coeffs[k];
+        });
+    return x - v / d;
+}
+
+// Index of the root nearest to x, with its squared distance in `hyp`, chosen by selects rather than branches.
+template <size_t N, typename T>
+static size_t nearest_root(const Complex<T> x, const Polynomial<N, T>& p, T& hyp) {
+    size_t best = 0;
+    hyp = norm2(x - p.roots[0]);
+    unroll<N - 1>([&](auto i) {
+        constexpr size_t k = decltype(i)::value + 1;
+        const T d = norm2(x - p.roots[k]);
+        const bool closer = d < hyp;
+        best = closer ? k : best;
+        hyp = closer ? d : hyp;
+        });
+    return best;
+}
+
+template <size_t N, typename T>
+static size_t closest_root(const Complex<T> x, const Polynomial<N, T>& p) {
+    T hyp;
+    return nearest_root(x, p, hyp);
+}
+
+// As nearest_root, given the root nearest to the previous iterate: while x stays within that root's isolation
+// radius it is the only one measured, so converging iterates cost one distance per step instead of N.
+template <size_t N, typename T>
+static size_t track_root(const Complex<T> x, const Polynomial<N, T>& p, const size_t previous, T& hyp) {
+    hyp = norm2(x - p.roots[previous]);
+    return hyp < p.isolation[previous] ? previous : nearest_root(x, p, hyp);
+}
+
+// A pixel has converged once its nearest root, at squared distance `hyp`, is within the root tolerance or the
+// Newton step has stalled.
+template <typename T>
+static bool has_converged(const Complex<T> step, const T hyp) {
+    return norm2(step) < T(Tolerance<T>::step) || hyp < T(Tolerance<T>::root);
+}
+
+// The view's origin and pixel spacing, converted on the host so kernels never touch the view's doubles.
+template <typename T>
+struct Grid {
+    Coord<T> left, top, unit;
+};
+
+template <typename T>
+static Grid<T> make_grid(const View& view) {
+    return Grid<T>{ static_cast<Coord<T>>(view.left), static_cast<Coord<T>>(view.top), static_cast<Coord<T>>(view.unit) };
+}
+
+template <typename T>
+static Complex<T> pixel_to_complex(const Grid<T>& grid, const size_t x, const size_t y) {
+    return to_complex<T>(
+        grid.left + grid.unit * static_cast<Coord<T>>(x),
+        grid.top - grid.unit * static_cast<Coord<T>>(y)
+    );
+}
+
+// Base RGB colour of each root; the first three are blue, green and red.
+constexpr uint32_t ROOT_COLORS[MAX_ROOTS] = { 0x0000FF, 0x00FF00, 0xFF0000, 0xFFFF00, 0xFF00FF, 0x00FFFF, 0xFF8000, 0x8000FF };
+
+// Packed ARGB8888 pixel: the root's colour scaled by `intensity`.
+static uint32_t root_color(const size_t root, const uint8_t intensity) {
+    const uint32_t base = ROOT_COLORS[root];
+    uint32_t color = 0xFF000000u;
+    for (uint32_t shift = 0; shift < 24; shift += 8) color |= ((base >> shift) & 0xFF) * intensity / 255 << shift;
+    return color;
+}
+
+// Colour ramp of every root, PALETTE_SIZE entries from no iterations to the whole budget (or one band, when
+// cyclic). Kernels capture it by value, which places it in constant parameter memory.
+struct PaletteLut {
+    uint32_t ramp[MAX_ROOTS][PALETTE_SIZE];
+    // Ramp entries per iteration budget (per iteration, when cyclic), and the log of the squared root tolerance
+    // the samples were iterated to.
+    float scale, log_tolerance;
+    bool smooth, cyclic;
+};
+
+static uint32_t mix_color(const uint32_t a, const uint32_t b, const float t) {
+    uint32_t color = 0xFF000000u;
+    for (uint32_t shift = 0; shift < 24; shift += 8) {
+        const float x = static_cast<float>((a >> shift) & 0xFF), y = static_cast<float>((b >> shift) & 0xFF);
+        color |= static_cast<uint32_t>(x + (y - x) * t + 0.5f) << shift;
+    }
+    return color;
+}
+
+template <typename T>
+static PaletteLut make_palette(const View& view) {
+    PaletteLut lut{};
+    lut.smooth = view.palette != Palette::Classic && view.palette != Palette::Index;
+    lut.cyclic = view.palette == Palette::Bands;
+    lut.scale = lut.cyclic ? PALETTE_SIZE / PALETTE_BAND_ITERATIONS : static_cast<float>(PALETTE_SIZE - 1);
+    lut.log_tolerance = std::log(static_cast<float>(Tolerance<T>::root));
+    for (size_t r = 0; r < MAX_ROOTS; ++r) {
+        for (size_t i = 0; i < PALETTE_SIZE; ++i) {
+            const float t = static_cast<float>(i) / (PALETTE_SIZE - 1);
+            uint32_t& entry = lut.ramp[r][i];
+            switch (view.palette) {
+            case Palette::Classic:
+            case Palette::Smooth:
+                entry = root_color(r, static_cast<uint8_t>(FILL_INTENSITY - (FILL_INTENSITY - MIN_INTENSITY) * t + 0.5f));
+                break;
+            case Palette::Pastel:
+                entry = mix_color(mix_color(ROOT_COLORS[r], 0xFFFFFF, 0.6f), root_color(r, MIN_INTENSITY / 2), t);
+                break;
+            case Palette::Bands:
+                entry = root_color(r, static_cast<uint8_t>(MIN_INTENSITY + (FILL_INTENSITY - MIN_INTENSITY) * 0.5f
+                    * (1.0f + std::cos(6.2831853f * static_cast<float>(i) / PALETTE_SIZE))));
+                break;
+            case Palette::Index:
+                entry = 0xFF000000u | static_cast<uint32_t>(r) << 16 | static_cast<uint32_t>(255.0f * t + 0.5f) << 8;
+                break;
+            }
+        }
+    }
+    return lut;
+}
+
+// Fraction of its last iteration a sample needed to get within the root tolerance, from the squared length of
+// that last step: with quadratic convergence the log of the squared error doubles every iteration.
+static float last_step_fraction(const float log_tolerance, const float step2) {
+    const float s = sycl::log(sycl::fmax(step2, std::numeric_limits<float>::min()));
+    if (s >= 0.0f) return 1.0f;
+    return sycl::clamp(sycl::log2(log_tolerance / s), 0.0f, 1.0f);
+}
+
+// Packed ARGB8888 pixel of a sample that reached `root` after `count` of `iterations`, the last of which it
+// needed `fraction` of; samples that ran out of iterations pass 1.
+static uint32_t palette_color(
+    const PaletteLut& lut, const size_t root, const uint32_t count, const float fraction, const uint32_t iterations
+) {
+    const float mu = lut.smooth ? static_cast<float>(count) - 1.0f + fraction : static_cast<float>(count);
+    const float scale = lut.cyclic ? lut.scale : lut.scale / sycl::fmax(static_cast<float>(iterations), 1.0f);
+    float pos = sycl::fmax(mu, 0.0f) * scale;
+    if (lut.cyclic) pos -= PALETTE_SIZE * sycl::floor(pos / PALETTE_SIZE);
+    else pos = sycl::fmin(pos, static_cast<float>(PALETTE_SIZE - 1));
+    const size_t i = static_cast<size_t>(pos) % PALETTE_SIZE;
+    const size_t j = lut.cyclic ? (i + 1) % PALETTE_SIZE : std::min(i + 1, PALETTE_SIZE - 1);
+    return mix_color(lut.ramp[root][i], lut.ramp[root][j], pos - static_cast<float>(i));
+}
+
+// Calls f(integral_constant<N>(), T()) for the view's root count; every degree is instantiated at compile time.
+// FPGA builds instantiate FPGA_ROOT_COUNT alone, as every degree would be a datapath of its own in the bitstream.
+template <typename T, typename F>
+static void dispatch_roots(const size_t root_count, F&& f) {
+#if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
+    if (root_count == FPGA_ROOT_COUNT) f(std::integral_constant<size_t, FPGA_ROOT_COUNT>(), T());
+#else
+    switch (root_count) {
+    case 3:
+        f(std::integral_constant<size_t, 3>(), T());
+        break;
+    case 4:
+        f(std::integral_constant<size_t, 4>(), T());
+        break;
+    case 5:
+        f(std::integral_constant<size_t, 5>(), T());
+        break;
+    case 6:
+        f(std::integral_constant<size_t, 6>(), T());
+        break;
+    case 7:
+        f(std::integral_constant<size_t, 7>(), T());
+        break;
+    case 8:
+        f(std::integral_constant<size_t, 8>(), T());
+        break;
+    }
+#endif
+}
+
+// As dispatch_roots, also picking the scalar type from the view's precision.
+template <typename F>
+static void dispatch(const View& view, F&& f) {
+    switch (view.precision) {
+    case Precision::Half:
+        dispatch_roots<sycl::half>(view.root_count, f);
+        break;
+    case Precision::Float:
+        dispatch_roots<float>(view.root_count, f);
+        break;
+    case Precision::Double:
+        dispatch_roots<double>(view.root_count, f);
+        break;
+    case Precision::DoubleFloat:
+        dispatch_roots<DoubleFloat>(view.root_count, f);
+        break;
+    }
+}
+
+enum class IterateStorage {
+    Float,
+    Half,
+    Fixed,
+};
+
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+static const char* iterate_storage_name(const IterateStorage storage) {
+    switch (storage) {
+    case IterateStorage::Float:
+        return "float";
+    case IterateStorage::Half:
+        return "half";
+    case IterateStorage::Fixed:
+        return "fixed";
+    }
+    return "unknown";
+}
+#endif
+
+struct FloatIterate {
+    typedef Complex<float> type;
+
+    static type encode(const Complex<float> x, const float) {
+        return x;
+    }
+
+    static Complex<float> decode(const type v, const float) {
+        return v;
+    }
+};
+
+struct HalfIterate {
+    struct type {
+        sycl::half real, imag;
+    };
+
+    static type encode(const Complex<float> x, const float) {
+        return type{ sycl::half(x.re), sycl::half(x.im) };
+    }
+
+    static Complex<float> decode(const type v, const float) {
+        return Complex<float>{ static_cast<float>(v.real), static_cast<float>(v.imag) };
+    }
+};
+
+// Both parts packed as signed 16-bit fixed-point into one word; `scale` maps the frame's range onto the int16 span.
+struct FixedIterate {
+    typedef uint32_t type;
+
+    static type encode(const Complex<float> x, const float scale) {
+        const float re = sycl::clamp(x.re * scale, -32767.0f, 32767.0f);
+        const float im = sycl::clamp(x.im * scale, -32767.0f, 32767.0f);
+        const uint16_t re_bits = static_cast<uint16_t>(static_cast<int16_t>(re));
+        const uint16_t im_bits = static_cast<uint16_t>(static_cast<int16_t>(im));
+        return static_cast<uint32_t>(re_bits) | (static_cast<uint32_t>(im_bits) << 16);
+    }
+
+    static Complex<float> decode(const type v, const float scale) {
+        const int16_t re = static_cast<int16_t>(v & 0xFFFF);
+        const int16_t im = static_cast<int16_t>(v >> 16);
+        return Complex<float>{ re / scale, im / scale };
+    }
+};
+
+static size_t iterate_size(const IterateStorage storage) {
+    switch (storage) {
+    case IterateStorage::Float:
+        return sizeof(FloatIterate::type);
+    case IterateStorage::Half:
+        return sizeof(HalfIterate::type);
+    case IterateStorage::Fixed:
+        return sizeof(FixedIterate::type);
+    }
+    return sizeof(FloatIterate::type);
+}
+
+// Cached tiles have one sample per pixel, so the antialiasing mode is not part of the key.
+struct TileKey {
+    View view;
+    int64_t x, y;
+
+    bool operator==(const TileKey& o) const {
+        return same_roots(view, o.view) && view.unit == o.view.unit && view.iterations == o.view.iterations
+            && view.precision == o.view.precision && view.palette == o.view.palette && x == o.x && y == o.y;
+    }
+};
+
+struct TileKeyHash {
+    size_t operator()(const TileKey& k) const {
+        size_t seed = 0;
+        const auto combine = [&seed](const size_t v) { seed ^= v + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2); };
+        for (size_t i = 0; i < k.view.root_count; ++i) {
+            combine(std::hash<float>()(k.view.roots[i].real()));
+            combine(std::hash<float>()(k.view.roots[i].imag()));
+        }
+        combine(std::hash<double>()(k.view.unit));
+        combine(std::hash<int64_t>()(k.x));
+        combine(std::hash<int64_t>()(k.y));
+        combine(std::hash<size_t>()(k.view.iterations));
+        combine(static_cast<size_t>(k.view.precision));
+        combine(static_cast<size_t>(k.view.palette));
+        return seed;
+    }
+};
+
+// A tile to render: the cache slot receiving it and its position on the world tile grid.
+struct TileJob {
+    uint32_t slot;
+    int64_t x, y;
+};
+
+// LRU cache of finished TILE_SIZE x TILE_SIZE tiles kept in device memory, one slot per tile.
+struct TileCache {
+    sycl::queue& q;
+    size_t capacity = 0;
+    uint32_t* slots = nullptr;
+    TileJob* jobs = nullptr;
+    uint32_t* table = nullptr;
+    std::vector<TileJob> pending;
+    std::vector<uint32_t> visible;
+    std::list<TileKey> lru;
+    std::unordered_map<TileKey, std::pair<uint32_t, std::list<TileKey>::iterator>, TileKeyHash> entries;
+    std::vector<uint32_t> free_slots;
+    size_t local_size = 0;
+    size_t hits = 0, misses = 0;
+
+    explicit TileCache(sycl::queue& q) : q(q) {}
+
+    TileCache(const TileCache&) = delete;
+    TileCache& operator=(const TileCache&) = delete;
+
+    ~TileCache() {
+        release();
+    }
+
+    // Makes room for at least `count` tiles at once; growing drops every cached tile.
+    void reserve(const size_t count) {
+        if (count <= capacity) return;
+        release();
+        capacity = std::max(TILE_CACHE_SLOTS, count * 2);
+        slots = sycl::malloc_device<uint32_t>(capacity * TILE_SIZE * TILE_SIZE, q);
+        jobs = sycl::malloc_device<TileJob>(capacity, q);
+        table = sycl::malloc_device<uint32_t>(capacity, q);
+        if (slots == nullptr || jobs == nullptr || table == nullptr) {
+            release();
+            throw std::bad_alloc();
+        }
+        clear();
+    }
+
+    // Forgets every cached tile, keeping the slots allocated.
+    void clear() {
+        lru.clear();
+        entries.clear();
+        free_slots.clear();
+        for (size_t i = capacity; i > 0; --i) free_slots.push_back(static_cast<uint32_t>(i - 1));
+    }
+
+    // Returns the slot holding `key`, claiming the least recently used one on a miss.
+    uint32_t acquire(const TileKey& key, bool& hit) {
+        const auto found = entries.find(key);
+        hit = found != entries.end();
+        if (hit) {
+            lru.splice(lru.begin(), lru, found->second.second);
+            ++hits;
+            return found->second.first;
+        }
+        uint32_t slot;
+        if (!free_slots.empty()) {
+            slot = free_slots.back();
+            free_slots.pop_back();
+        }
+        else {
+            const auto evicted = entries.find(lru.back());
+            slot = evicted->second.first;
+            entries.erase(evicted);
+            lru.pop_back();
+        }
+        lru.push_front(key);
+        entries.emplace(key, std::make_pair(slot, lru.begin()));
+        ++misses;
+        return slot;
+    }
+
+    void release() {
+        q.wait();
+        if (slots != nullptr) sycl::free(slots, q);
+        if (jobs != nullptr) sycl::free(jobs, q);
+        if (table != nullptr) sycl::free(table, q);
+        slots = nullptr;
+        jobs = nullptr;
+        table = nullptr;
+        capacity = 0;
+        lru.clear();
+        entries.clear();
+        free_slots.clear();
+    }
+};
+
+// Square of the boundary engine at one subdivision level; the square is clipped to the image.
+struct BoundaryTile {
+    uint32_t x, y;
+};
+
+// Work-group shapes the tile kernel can be launched with; each side divides TILE_SIZE.
+constexpr size_t TILE_LOCAL_SIZES[][2] = { { 8, 8 }, { 16, 16 }, { 4, 64 }, { 8, 32 }, { 1, 64 } };
+constexpr size_t TILE_LOCAL_SIZE_COUNT = sizeof(TILE_LOCAL_SIZES) / sizeof(TILE_LOCAL_SIZES[0]);
+
+// A command queued while tracing; `transfer` marks copies as opposed to kernels.
+struct TraceEvent {
+    const char* name;
+    bool transfer;
+    sycl::event event;
+};
+
+// Device-resident state reused across frames for the lifetime of the queue.
+struct RenderContext {
+    sycl::queue& q;
+    size_t width = 0, height = 0;
+    uint32_t* image = nullptr;
+    uint32_t* back_image = nullptr;
+    uint32_t* staging = nullptr;
+    // Cleared when the caller reads ctx.image itself, e.g. straight into a locked texture.
+    bool stage_output = true;
+    void* iterates = nullptr;
+    size_t iterate_bytes = 0;
+    uint32_t* counts = nullptr;
+    // Set while iterates and counts hold the root-drag frame of warm_view in float storage; warm_primed is the
+    // view they were last iterated from their seeds for.
+    bool warm = false;
+    View warm_view{}, warm_primed{};
+    uint32_t* row_counter = nullptr;
+    // Per-frame parameters of a sweep batch.
+    void* frame_params = nullptr;
+    size_t frame_param_bytes = 0;
+    // While count_work is set the fused engine sums the iterations it performed into work_host[0] and the
+    // samples that ran out of iterations into work_host[1]; the device must have aspect::atomic64.
+    bool count_work = false;
+    uint64_t* work = nullptr;
+    uint64_t work_host[2] = {};
+    // Tile lists of two consecutive subdivision levels, per-tile outcome and the next level's tile count.
+    BoundaryTile* boundary_tiles[2] = {};
+    uint32_t* boundary_fill = nullptr;
+    uint32_t* boundary_count = nullptr;
+    TileCache tiles;
+    // Second in-order queue on the same device, for kernels that must run alongside those on q.
+    std::unique_ptr<sycl::queue> side;
+    // Commands are only recorded while tracing is set; timing them needs a queue with enable_profiling.
+    bool tracing = false;
+    std::vector<TraceEvent> trace;
+
+    RenderContext(sycl::queue& q, const size_t width, const size_t height) : q(q), tiles(q) {
+        resize(width, height);
+    }
+
+    RenderContext(const RenderContext&) = delete;
+    RenderContext& operator=(const RenderContext&) = delete;
+
+    ~RenderContext() {
+        release();
+    }
+
+    size_t pixel_count() const {
+        return width * height;
+    }
+
+    sycl::event record(const char* name, const sycl::event event, const bool transfer = false) {
+        if (tracing) trace.push_back(TraceEvent{ name, transfer, event });
+        return event;
+    }
+
+    // Reallocates the image for the new resolution; the iterate buffer is reallocated lazily on next use.
+    void resize(const size_t w, const size_t h) {
+        if (w == width && h == height && image != nullptr) return;
+        release();
+        width = w;
+        height = h;
+        image = sycl::malloc_device<uint32_t>(pixel_count(), q);
+        staging = sycl::malloc_host<uint32_t>(pixel_count(), q);
+        if (image == nullptr || staging == nullptr) {
+            release();
+            throw std::bad_alloc();
+        }
+    }
+
+    // Second device image for kernels that read the previous frame while writing the next one.
+    void reserve_back_image() {
+        if (back_image != nullptr) return;
+        back_image = sycl::malloc_device<uint32_t>(pixel_count(), q);
+        if (back_image == nullptr) throw std::bad_alloc();
+    }
+
+    void reserve_iterates(const IterateStorage storage) {
+        const size_t bytes = pixel_count() * iterate_size(storage);
+        if (iterates != nullptr && iterate_bytes == bytes) return;
+        release_iterates();
+        iterates = sycl::malloc_device(bytes, q);
+        counts = sycl::malloc_device<uint32_t>(pixel_count(), q);
+        if (iterates == nullptr || counts == nullptr) {
+            release_iterates();
+            throw std::bad_alloc();
+        }
+        iterate_bytes = bytes;
+    }
+
+    // Allocates what the engines would otherwise allocate mid-frame, where growing a buffer waits for the queue:
+    // iterates in `storage`, the back image and the tiles of a whole frame. The boundary engine's buffers are left
+    // out, as that engine is never pipelined.
+    void reserve_frame(const IterateStorage storage) {
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+        reserve_iterates(storage);
+        reserve_back_image();
+        tiles.reserve((width / TILE_SIZE + 2) * (height / TILE_SIZE + 2));
+#endif
+    }
+
+    void reserve_row_counter() {
+        if (row_counter != nullptr) return;
+        row_counter = sycl::malloc_device<uint32_t>(1, q);
+        if (row_counter == nullptr) throw std::bad_alloc();
+    }
+
+    void reserve_frame_params(const size_t bytes) {
+        if (frame_params != nullptr && frame_param_bytes >= bytes) return;
+        q.wait();
+        if (frame_params != nullptr) sycl::free(frame_params, q);
+        frame_params = sycl::malloc_device(bytes, q);
+        frame_param_bytes = frame_params == nullptr ? 0 : bytes;
+        if (frame_params == nullptr) throw std::bad_alloc();
+    }
+
+    sycl::queue& reserve_side_queue() {
+        if (!side) side = std::make_unique<sycl::queue>(q.get_context(), q.get_device(), sycl::property::queue::in_order());
+        return *side;
+    }
+
+    void reserve_work() {
+        if (work != nullptr) return;
+        work = sycl::malloc_device<uint64_t>(2, q);
+        if (work == nullptr) throw std::bad_alloc();
+    }
+
+    // Sized for the finest level, where every BOUNDARY_MIN_TILE square may be a tile.
+    void reserve_boundary() {
+        if (boundary_fill != nullptr) return;
+        const size_t most = ((width + BOUNDARY_MIN_TILE - 1) / BOUNDARY_MIN_TILE) * ((height + BOUNDARY_MIN_TILE - 1) / BOUNDARY_MIN_TILE);
+        boundary_tiles[0] = sycl::malloc_device<BoundaryTile>(most, q);
+        boundary_tiles[1] = sycl::malloc_device<BoundaryTile>(most, q);
+        boundary_fill = sycl::malloc_device<uint32_t>(most, q);
+        boundary_count = sycl::malloc_device<uint32_t>(1, q);
+        if (boundary_tiles[0] == nullptr || boundary_tiles[1] == nullptr || boundary_fill == nullptr || boundary_count == nullptr) {
+            release_boundary();
+            throw std::bad_alloc();
+        }
+    }
+
+    void release_boundary() {
+        for (BoundaryTile*& t : boundary_tiles) {
+            if (t != nullptr) sycl::free(t, q);
+            t = nullptr;
+        }
+        if (boundary_fill != nullptr) sycl::free(boundary_fill, q);
+        if (boundary_count != nullptr) sycl::free(boundary_count, q);
+        boundary_fill = nullptr;
+        boundary_count = nullptr;
+    }
+
+    void release_iterates() {
+        q.wait();
+        if (iterates != nullptr) sycl::free(iterates, q);
+        if (counts != nullptr) sycl::free(counts, q);
+        iterates = nullptr;
+        iterate_bytes = 0;
+        counts = nullptr;
+        warm = false;
+    }
+
+    void release() {
+        if (side) side->wait();
+        release_iterates();
+        release_boundary();
+        if (image != nullptr) sycl::free(image, q);
+        if (back_image != nullptr) sycl::free(back_image, q);
+        if (staging != nullptr) sycl::free(staging, q);
+        if (row_counter != nullptr) sycl::free(row_counter, q);
+        if (work != nullptr) sycl::free(work, q);
+        if (frame_params != nullptr) sycl::free(frame_params, q);
+        image = nullptr;
+        back_image = nullptr;
+        staging = nullptr;
+        row_counter = nullptr;
+        work = nullptr;
+        frame_params = nullptr;
+        frame_param_bytes = 0;
+    }
+};
+
+// FPGA builds leave out every engine but the pipelined one, whose kernels are all the bitstream holds.
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+// Largest magnitude an iterate is expected to reach this frame, used to scale fixed-point storage.
+static float iterate_range(const View& view, const size_t w, const size_t h) {
+    const double right = view.left + view.unit * w;
+    const double bottom = view.top - view.unit * h;
+    double range = std::max({ std::abs(view.left), std::abs(right), std::abs(view.top), std::abs(bottom) });
+    for (size_t i = 0; i < view.root_count; ++i) range = std::max(range, static_cast<double>(std::abs(view.roots[i])));
+    return static_cast<float>(range * 2.0);
+}
+
+// The multi-pass engine iterates in float: its iterates round-trip through storage no wider than that anyway.
+template <size_t N, typename Storage>
+static void newton_multi_pass(RenderContext& ctx, const View& view) {
+    typedef typename Storage::type iterate;
+    sycl::queue& q = ctx.q;
+    const size_t w = ctx.width, h = ctx.height;
+    const Polynomial<N, float> poly = make_polynomial<N, float>(view);
+    const Grid<float> grid = make_grid<float>(view);
+    const PaletteLut lut = make_palette<float>(view);
+    const uint32_t max_count = static_cast<uint32_t>(view.iterations);
+    // Counts hold the iterations taken in their upper bits and the last step's fraction in COUNT_FRACTION_BITS.
+    const uint32_t one = 1u << COUNT_FRACTION_BITS;
+    const uint32_t running = max_count << COUNT_FRACTION_BITS | (one - 1);
+    const float log_tolerance = lut.log_tolerance;
+    const float scale = 32767.0f / iterate_range(view, w, h);
+    sycl::range<2> num_items{ h, w };
+    iterate* vec = static_cast<iterate*>(ctx.iterates);
+    uint32_t* count = ctx.counts;
+    uint32_t* out = ctx.image;
+    ctx.warm = false;
+    ctx.record("seed", q.parallel_for(num_items, [=](auto i) {
+        const size_t index = i[0] * w + i[1];
+        vec[index] = Storage::encode(pixel_to_complex(grid, i[1], i[0]), scale);
+        count[index] = running;
+        }));
+    for (uint32_t pass = 0; pass < max_count; ++pass) {
+        ctx.record("pass", q.parallel_for(num_items, [=](auto i) {
+            const size_t index = i[0] * w + i[1];
+            if (count[index] != running) return;
+            const Complex<float> x = Storage::decode(vec[index], scale);
+            const Complex<float> next = newton_step(x, poly);
+            vec[index] = Storage::encode(next, scale);
+            float hyp;
+            nearest_root(next, poly, hyp);
+            if (!has_converged(next - x, hyp)) return;
+            const float fraction = last_step_fraction(log_tolerance, norm2(next - x));
+            count[index] = (pass + 1) << COUNT_FRACTION_BITS | static_cast<uint32_t>(fraction * (one - 1) + 0.5f);
+            }));
+    }
+    ctx.record("classify", q.parallel_for(num_items, [=](auto i) {
+        const size_t index = i[0] * w + i[1];
+        const Complex<float> x = Storage::decode(vec[index], scale);
+        const uint32_t c = count[index];
+        const float fraction = static_cast<float>(c & (one - 1)) / (one - 1);
+        out[index] = palette_color(lut, closest_root(x, poly), c >> COUNT_FRACTION_BITS, fraction, max_count);
+        }));
+}
+
+static void newton_multi_pass(RenderContext& ctx, const IterateStorage storage, const View& view) {
+    ctx.reserve_iterates(storage);
+    dispatch_roots<float>(view.root_count, [&](auto n, auto) {
+        constexpr size_t N = decltype(n)::value;
+        switch (storage) {
+        case IterateStorage::Float:
+            newton_multi_pass<N, FloatIterate>(ctx, view);
+            break;
+        case IterateStorage::Half:
+            newton_multi_pass<N, HalfIterate>(ctx, view);
+            break;
+        case IterateStorage::Fixed:
+            newton_multi_pass<N, FixedIterate>(ctx, view);
+            break;
+        }
+        });
+}
+
+// Iterates from `v` to convergence and returns the packed colour; `count` receives the iterations taken and
+// `converged` whether the sample got within the root tolerance in them.
+template <size_t N, typename T>
+static uint32_t render_point(
+    const Polynomial<N, T>& poly, const PaletteLut& lut, Complex<T> v, const uint32_t iterations, uint32_t& count,
+    bool& converged
+) {
+    float fraction = 1.0f;
+    size_t root = 0;
+    T hyp;
+    count = 0;
+    converged = false;
+    while (count < iterations) {
+        const Complex<T> next = newton_step(v, poly);
+        const Complex<T> step = next - v;
+        v = next;
+        ++count;
+        root = track_root(v, poly, root, hyp);
+        if (has_converged(step, hyp)) {
+            if (lut.smooth) fraction = last_step_fraction(lut.log_tolerance, to_float(norm2(step)));
+            converged = true;
+            break;
+        }
+    }
+    if (count == 0) root = closest_root(v, poly);
+    return palette_color(lut, root, count, fraction, iterations);
+}
+
+template <size_t N, typename T>
+static uint32_t render_point(
+    const Polynomial<N, T>& poly, const PaletteLut& lut, const Complex<T> v, const uint32_t iterations, uint32_t& count
+) {
+    bool converged;
+    return render_point(poly, lut, v, iterations, count, converged);
+}
+
+template <size_t N, typename T>
+static uint32_t render_point(const Polynomial<N, T>& poly, const PaletteLut& lut, const Complex<T> v, const uint32_t iterations) {
+    uint32_t count;
+    return render_point(poly, lut, v, iterations, count);
+}
+
+template <size_t N, typename T>
+static uint32_t render_pixel(
+    const Grid<T>& grid, const Polynomial<N, T>& poly, const PaletteLut& lut,
+    const size_t x, const size_t y, const uint32_t iterations
+) {
+    return render_point(poly, lut, pixel_to_complex(grid, x, y), iterations);
+}
+
+// Position in [0, 1) of sample `i` within its grid cell of pixel (x, y); the same for every frame.
+static float jitter(const size_t x, const size_t y, const uint32_t i) {
+    uint32_t k = static_cast<uint32_t>(x) * 73856093u ^ static_cast<uint32_t>(y) * 19349663u ^ i * 83492791u;
+    k ^= k >> 16;
+    k *= 0x45D9F3Bu;
+    k ^= k >> 16;
+    return static_cast<float>(k & 0xFFFF) / 65536.0f;
+}
+
+// Mean colour of `side` x `side` samples spread over pixel (x, y): at the centres of a regular grid or, when
+// `jittered`, anywhere in each grid cell. `count` receives the iterations all samples took together and
+// `saturated` the number of samples that did not converge in theirs.
+template <size_t N, typename T>
+static uint32_t render_supersampled(
+    const Grid<T>& grid, const Polynomial<N, T>& poly, const PaletteLut& lut, const size_t x, const size_t y,
+    const uint32_t side, const bool jittered, const uint32_t iterations, uint32_t& count, uint32_t& saturated
+) {
+    uint32_t sum[3] = {};
+    count = 0;
+    saturated = 0;
+    for (uint32_t i = 0; i < side * side; ++i) {
+        const float u = jittered ? jitter(x, y, 2 * i) : 0.5f, v = jittered ? jitter(x, y, 2 * i + 1) : 0.5f;
+        const float ox = (static_cast<float>(i % side) + u) / side - 0.5f, oy = (static_cast<float>(i / side) + v) / side - 0.5f;
+        const Complex<T> start = to_complex<T>(
+            grid.left + grid.unit * (static_cast<Coord<T>>(x) + static_cast<Coord<T>>(ox)),
+            grid.top - grid.unit * (static_cast<Coord<T>>(y) + static_cast<Coord<T>>(oy))
+        );
+        uint32_t n;
+        bool converged;
+        const uint32_t color = render_point(poly, lut, start, iterations, n, converged);
+        for (uint32_t c = 0; c < 3; ++c) sum[c] += (color >> (8 * c)) & 0xFF;
+        count += n;
+        saturated += !converged;
+    }
+    const uint32_t samples = side * side;
+    return 0xFF000000u | (sum[2] + samples / 2) / samples << 16 | (sum[1] + samples / 2) / samples << 8 | (sum[0] + samples / 2) / samples;
+}
+
+static bool contrasting(const uint32_t a, const uint32_t b) {
+    for (uint32_t shift = 0; shift < 24; shift += 8) {
+        const int32_t d = static_cast<int32_t>((a >> shift) & 0xFF) - static_cast<int32_t>((b >> shift) & 0xFF);
+        if (static_cast<uint32_t>(d < 0 ? -d : d) > ANTIALIAS_CONTRAST) return true;
+    }
+    return false;
+}
+
+// Second pass of adaptive supersampling: reads the one-sample image from `in` and writes it to `out`, with the
+// pixels that contrast with a 4-neighbour re-rendered from jittered samples.
+template <size_t N, typename T>
+static void refine_edges(RenderContext& ctx, const View& view, const uint32_t* in, uint32_t* out) {
+    const size_t w = ctx.width, h = ctx.height;
+    const Polynomial<N, T> poly = make_polynomial<N, T>(view);
+    const Grid<T> grid = make_grid<T>(view);
+    const PaletteLut lut = make_palette<T>(view);
+    const uint32_t iterations = static_cast<uint32_t>(view.iterations);
+    ctx.record("antialias", ctx.q.parallel_for(sycl::range<2>{ h, w }, [=](auto i) {
+        const size_t y = i[0], x = i[1];
+        const uint32_t color = in[y * w + x];
+        const bool edge = (x > 0 && contrasting(color, in[y * w + x - 1])) || (x + 1 < w && contrasting(color, in[y * w + x + 1]))
+            || (y > 0 && contrasting(color, in[(y - 1) * w + x])) || (y + 1 < h && contrasting(color, in[(y + 1) * w + x]));
+        uint32_t count, saturated;
+        out[y * w + x] = edge ? render_supersampled(grid, poly, lut, x, y, ADAPTIVE_SIDE, true, iterations, count, saturated) : color;
+        }));
+}
+
+// Samples one pixel per `block` x `block` square and fills the square with it. When `refine` is set the image
+// already holds the pass at twice this block size, so squares whose sample was taken by that pass are skipped.
+// Supersampled views average antialias_side() squared samples per pixel, and the adaptive mode adds a pass.
+template <size_t N, typename T>
+static void newton_fused(RenderContext& ctx, const View& view, const size_t block, const bool refine) {
+    const size_t w = ctx.width, h = ctx.height;
+    const Polynomial<N, T> poly = make_polynomial<N, T>(view);
+    const Grid<T> grid = make_grid<T>(view);
+    const PaletteLut lut = make_palette<T>(view);
+    const uint32_t iterations = static_cast<uint32_t>(view.iterations);
+    const uint32_t side = antialias_side(view.antialias);
+    sycl::range<2> num_items{ (h + block - 1) / block, (w + block - 1) / block };
+    uint32_t* out = ctx.image;
+    uint64_t* work = nullptr;
+    if (ctx.count_work) {
+        ctx.reserve_work();
+        work = ctx.work;
+        ctx.record("work", ctx.q.memset(work, 0, 2 * sizeof(uint64_t)));
+    }
+    ctx.record("fused", ctx.q.parallel_for(num_items, [=](auto i) {
+        const size_t y0 = i[0] * block, x0 = i[1] * block;
+        if (refine && y0 % (block * 2) == 0 && x0 % (block * 2) == 0) return;
+        uint32_t count, saturated = 0;
+        bool converged = true;
+        const uint32_t color = side > 1 ? render_supersampled(grid, poly, lut, x0, y0, side, false, iterations, count, saturated)
+            : render_point(poly, lut, pixel_to_complex(grid, x0, y0), iterations, count, converged);
+        const size_t y1 = std::min(y0 + block, h), x1 = std::min(x0 + block, w);
+        for (size_t y = y0; y < y1; ++y)
+            for (size_t x = x0; x < x1; ++x) out[y * w + x] = color;
+        if (work != nullptr) {
+            sycl::atomic_ref<uint64_t, sycl::memory_order::relaxed, sycl::memory_scope::device>(work[0]).fetch_add(count);
+            // A sample that converged on its last iteration does not count as saturated.
+            saturated += !converged;
+            if (saturated != 0) sycl::atomic_ref<uint64_t, sycl::memory_order::relaxed, sycl::memory_scope::device>(work[1]).fetch_add(saturated);
+        }
+        }));
+    if (work != nullptr) ctx.record("work", ctx.q.memcpy(ctx.work_host, work, sizeof(ctx.work_host)), true);
+    if (view.antialias == Antialias::Adaptive) {
+        ctx.reserve_back_image();
+        std::swap(ctx.image, ctx.back_image);
+        refine_edges<N, T>(ctx, view, ctx.back_image, ctx.image);
+    }
+}
+
+// Lane group of the SIMD engine: real and imaginary parts of SIMD_LANES horizontally adjacent pixels are kept in
+// separate vectors, and masks are -1 in active lanes and 0 elsewhere.
+typedef sycl::vec<float, SIMD_LANES> lanes;
+typedef sycl::vec<int32_t, SIMD_LANES> lane_mask;
+
+// Renders SIMD_LANES pixels of row y starting at column x0, iterating until every lane has converged.
+template <size_t N>
+static void render_lanes(
+    const Polynomial<N, float>& p, const Grid<float>& grid, const PaletteLut& lut, const uint32_t iterations,
+    const size_t x0, const size_t y, const size_t w, uint32_t* out
+) {
+    lanes xr, xi(grid.top - grid.unit * static_cast<float>(y));
+    for (int l = 0; l < SIMD_LANES; ++l) xr[l] = grid.left + grid.unit * static_cast<float>(x0 + l);
+    lane_mask active(-1), count(0);
+    // Squared length of each lane's latest step, frozen once the lane converges.
+    lanes last(1.0f);
+    for (uint32_t pass = 0; pass < iterations && sycl::any(active); ++pass) {
+        lanes vr(1.0f), vi(0.0f), dr(0.0f), di(0.0f);
+        unroll<N>([&](auto i) {
+            constexpr size_t k = N - 1 - decltype(i)::value;
+            const lanes ndr = dr * xr - di * xi + vr, ndi = dr * xi + di * xr + vi;
+            const lanes nvr = vr * xr - vi * xi + p.coeffs[k].re, nvi = vr * xi + vi * xr + p.coeffs[k].im;
+            dr = ndr, di = ndi, vr = nvr, vi = nvi;
+            });
+        // v / d as v * conj(d) * (1 / |d|^2): one reciprocal instead of two divisions.
+        const lanes inv = lanes(1.0f) / (dr * dr + di * di);
+        const lanes sr = (vr * dr + vi * di) * inv, si = (vi * dr - vr * di) * inv;
+        xr = sycl::select(xr, xr - sr, active);
+        xi = sycl::select(xi, xi - si, active);
+        count = count - active;
+        const lanes step2 = sr * sr + si * si;
+        last = sycl::select(last, step2, active);
+        lane_mask converged = step2 < lanes(STEP_EPSILON);
+        unroll<N>([&](auto i) {
+            const Complex<float> r = p.roots[decltype(i)::value];
+            const lanes er = xr - r.re, ei = xi - r.im;
+            converged = converged | (er * er + ei * ei < lanes(ROOT_TOLERANCE));
+            });
+        active = active & ~converged;
+    }
+    lane_mask best(0);
+    lanes best_hyp((xr - p.roots[0].re) * (xr - p.roots[0].re) + (xi - p.roots[0].im) * (xi - p.roots[0].im));
+    unroll<N - 1>([&](auto i) {
+        constexpr size_t k = decltype(i)::value + 1;
+        const lanes er = xr - p.roots[k].re, ei = xi - p.roots[k].im;
+        const lanes hyp = er * er + ei * ei;
+        const lane_mask closer = hyp < best_hyp;
+        best_hyp = sycl::select(best_hyp, hyp, closer);
+        best = sycl::select(best, lane_mask(static_cast<int32_t>(k)), closer);
+        });
+    for (int l = 0; l < SIMD_LANES && x0 + l < w; ++l) {
+        const float fraction = active[l] != 0 || !lut.smooth ? 1.0f : last_step_fraction(lut.log_tolerance, last[l]);
+        out[y * w + x0 + l] = palette_color(lut, static_cast<size_t>(best[l]), static_cast<uint32_t>(count[l]), fraction, iterations);
+    }
+}
+
+// CPU-oriented engine: one work-item per compute unit, each pulling whole rows from a shared counter so that
+// cores finishing cheap rows take over the remaining ones. Rows are rendered SIMD_LANES pixels at a time.
+template <size_t N>
+static void newton_simd(RenderContext& ctx, const View& view) {
+    const size_t w = ctx.width, h = ctx.height;
+    const Polynomial<N, float> poly = make_polynomial<N, float>(view);
+    const Grid<float> grid = make_grid<float>(view);
+    const PaletteLut lut = make_palette<float>(view);
+    const uint32_t iterations = static_cast<uint32_t>(view.iterations);
+    const size_t workers = ctx.q.get_device().get_info<sycl::info::device::max_compute_units>();
+    ctx.reserve_row_counter();
+    uint32_t* next_row = ctx.row_counter;
+    uint32_t* out = ctx.image;
+    ctx.record("rows", ctx.q.memset(next_row, 0, sizeof(uint32_t)));
+    ctx.record("simd", ctx.q.parallel_for(sycl::range<1>{ workers }, [=](auto) {
+        sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed, sycl::memory_scope::device> rows(*next_row);
+        for (size_t y = rows.fetch_add(1u); y < h; y = rows.fetch_add(1u))
+            for (size_t x0 = 0; x0 < w; x0 += SIMD_LANES) render_lanes(poly, grid, lut, iterations, x0, y, w, out);
+        }));
+}
+
+static int64_t floor_div(const int64_t a, const int64_t b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+template <size_t N, typename T>
+static void render_tiles(RenderContext& ctx, const View& view) {
+    TileCache& cache = ctx.tiles;
+    size_t local_y = TILE_LOCAL_SIZES[cache.local_size][0], local_x = TILE_LOCAL_SIZES[cache.local_size][1];
+    if (local_y * local_x > ctx.q.get_device().get_info<sycl::info::device::max_work_group_size>()) local_y = local_x = 1;
+    const Polynomial<N, T> poly = make_polynomial<N, T>(view);
+    const Coord<T> unit = static_cast<Coord<T>>(view.unit);
+    const PaletteLut lut = make_palette<T>(view);
+    const uint32_t iterations = static_cast<uint32_t>(view.iterations);
+    const int64_t tile = static_cast<int64_t>(TILE_SIZE);
+    const TileJob* jobs = cache.jobs;
+    uint32_t* slots = cache.slots;
+    const sycl::nd_range<2> range{ { cache.pending.size() * TILE_SIZE, TILE_SIZE }, { local_y, local_x } };
+    ctx.record("tiles", ctx.q.parallel_for(range, [=](sycl::nd_item<2> it) {
+        const size_t row = it.get_global_id(0) % TILE_SIZE, col = it.get_global_id(1);
+        const TileJob job = jobs[it.get_global_id(0) / TILE_SIZE];
+        const int64_t px = job.x * tile + static_cast<int64_t>(col);
+        const int64_t py = job.y * tile + static_cast<int64_t>(row);
+        const Complex<T> start = to_complex<T>(static_cast<Coord<T>>(px) * unit, -static_cast<Coord<T>>(py) * unit);
+        slots[job.slot * TILE_SIZE * TILE_SIZE + row * TILE_SIZE + col] = render_point(poly, lut, start, iterations);
+        }));
+}
+
+// Renders on a world-aligned tile grid where world pixel (px, py) samples (px * unit, -py * unit). Tiles are
+// looked up in the LRU cache and only the misses are rendered; the frame is then composited from the cache, so
+// the view is snapped to the nearest world pixel. Tiles take one sample per pixel; submit_newton sends
+// supersampled views to the fused engine instead.
+static void newton_tiled(RenderContext& ctx, const View& view) {
+    sycl::queue& q = ctx.q;
+    TileCache& cache = ctx.tiles;
+    const int64_t tile = static_cast<int64_t>(TILE_SIZE);
+    const int64_t w = static_cast<int64_t>(ctx.width), h = static_cast<int64_t>(ctx.height);
+    const int64_t px0 = std::llround(view.left / view.unit), py0 = std::llround(-view.top / view.unit);
+    const int64_t tx0 = floor_div(px0, tile), ty0 = floor_div(py0, tile);
+    const int64_t cols = floor_div(px0 + w - 1, tile) - tx0 + 1;
+    const int64_t rows = floor_div(py0 + h - 1, tile) - ty0 + 1;
+    cache.reserve(static_cast<size_t>(cols * rows));
+    cache.pending.clear();
+    cache.visible.resize(static_cast<size_t>(cols * rows));
+    for (int64_t ty = 0; ty < rows; ++ty) {
+        for (int64_t tx = 0; tx < cols; ++tx) {
+            const TileKey key{ view, tx0 + tx, ty0 + ty };
+            bool hit;
+            const uint32_t slot = cache.acquire(key, hit);
+            cache.visible[ty * cols + tx] = slot;
+            if (!hit) cache.pending.push_back(TileJob{ slot, tx0 + tx, ty0 + ty });
+        }
+    }
+    if (!cache.pending.empty()) {
+        ctx.record("tile jobs", q.memcpy(cache.jobs, cache.pending.data(), cache.pending.size() * sizeof(TileJob)), true);
+        dispatch(view, [&](auto n, auto t) {
+            render_tiles<decltype(n)::value, decltype(t)>(ctx, view);
+            });
+    }
+    const uint32_t* slots = cache.slots;
+    const uint32_t* table = cache.table;
+    uint32_t* out = ctx.image;
+    ctx.record("tile table", q.memcpy(cache.table, cache.visible.data(), cache.visible.size() * sizeof(uint32_t)), true);
+    ctx.record("composite", q.parallel_for(sycl::range<2>{ ctx.height, ctx.width }, [=](auto i) {
+        const int64_t px = px0 + static_cast<int64_t>(i[1]), py = py0 + static_cast<int64_t>(i[0]);
+        const int64_t tx = floor_div(px, tile), ty = floor_div(py, tile);
+        const uint32_t slot = table[(ty - ty0) * cols + (tx - tx0)];
+        out[i[0] * w + i[1]] = slots[slot * TILE_SIZE * TILE_SIZE + (py - ty * tile) * tile + (px - tx * tile)];
+        }));
+}
+
+// Outcome of checking a boundary tile's border: keep BOUNDARY_SPLIT to subdivide, BOUNDARY_ITERATE to iterate
+// its interior pixel by pixel, or any other value is the colour to fill the interior with. Real colours are
+// opaque, so neither marker can collide with one.
+constexpr uint32_t BOUNDARY_SPLIT = 0, BOUNDARY_ITERATE = 1;
+
+template <size_t N, typename T>
+static void render_boundary(RenderContext& ctx, const View& view) {
+    sycl::queue& q = ctx.q;
+    const uint32_t w = static_cast<uint32_t>(ctx.width), h = static_cast<uint32_t>(ctx.height);
+    const Polynomial<N, T> poly = make_polynomial<N, T>(view);
+    const Grid<T> grid = make_grid<T>(view);
+    const PaletteLut lut = make_palette<T>(view);
+    const uint32_t iterations = static_cast<uint32_t>(view.iterations);
+    // Roots in pixel coordinates: the iteration-count contours are nested around each root, so a tile holding
+    // one can have a uniform border and a different interior.
+    float root_x[N], root_y[N];
+    for (size_t r = 0; r < N; ++r) {
+        root_x[r] = static_cast<float>(std::clamp((view.roots[r].real() - view.left) / view.unit, -1e9, 1e9));
+        root_y[r] = static_cast<float>(std::clamp((view.top - view.roots[r].imag()) / view.unit, -1e9, 1e9));
+    }
+    std::vector<BoundaryTile> initial;
+    for (uint32_t y = 0; y < h; y += BOUNDARY_TILE)
+        for (uint32_t x = 0; x < w; x += BOUNDARY_TILE) initial.push_back(BoundaryTile{ x, y });
+    ctx.reserve_boundary();
+    BoundaryTile* tiles = ctx.boundary_tiles[0];
+    BoundaryTile* next = ctx.boundary_tiles[1];
+    uint32_t* fill = ctx.boundary_fill;
+    uint32_t* next_count = ctx.boundary_count;
+    uint32_t* out = ctx.image;
+    size_t count = initial.size();
+    ctx.record("boundary tiles", q.memcpy(tiles, initial.data(), count * sizeof(BoundaryTile)), true);
+    for (uint32_t size = BOUNDARY_TILE; count > 0; size /= 2) {
+        const bool split = size > BOUNDARY_MIN_TILE;
+        ctx.record("border", q.parallel_for(sycl::range<2>{ count, 4 * size }, [=](auto i) {
+            const BoundaryTile t = tiles[i[0]];
+            const uint32_t x1 = std::min(t.x + size, w) - 1, y1 = std::min(t.y + size, h) - 1;
+            const uint32_t side = static_cast<uint32_t>(i[1]) / size, k = static_cast<uint32_t>(i[1]) % size;
+            const uint32_t x = side < 2 ? t.x + k : side == 2 ? t.x : x1;
+            const uint32_t y = side >= 2 ? t.y + k : side == 0 ? t.y : y1;
+            if (x > x1 || y > y1) return;
+            // Pixels on the parent square's border were already rendered by the previous level.
+            if (size < BOUNDARY_TILE) {
+                const uint32_t px0 = t.x / (2 * size) * (2 * size), py0 = t.y / (2 * size) * (2 * size);
+                const uint32_t px1 = std::min(px0 + 2 * size, w) - 1, py1 = std::min(py0 + 2 * size, h) - 1;
+                if (x == px0 || x == px1 || y == py0 || y == py1) return;
+            }
+            out[y * w + x] = render_pixel(grid, poly, lut, x, y, iterations);
+            }));
+        if (split) ctx.record("boundary count", q.memset(next_count, 0, sizeof(uint32_t)));
+        ctx.record("classify", q.parallel_for(sycl::range<1>{ count }, [=](auto i) {
+            const size_t index = i[0];
+            const BoundaryTile t = tiles[index];
+            const uint32_t x1 = std::min(t.x + size, w) - 1, y1 = std::min(t.y + size, h) - 1;
+            const uint32_t color = out[t.y * w + t.x];
+            bool uniform = true;
+            for (uint32_t x = t.x; x <= x1 && uniform; ++x) uniform = out[t.y * w + x] == color && out[y1 * w + x] == color;
+            for (uint32_t y = t.y; y <= y1 && uniform; ++y) uniform = out[y * w + t.x] == color && out[y * w + x1] == color;
+            for (size_t r = 0; r < N && uniform; ++r)
+                uniform = root_x[r] < t.x || root_x[r] > x1 + 1.0f || root_y[r] < t.y || root_y[r] > y1 + 1.0f;
+            if (uniform || !split) {
+                fill[index] = uniform ? color : BOUNDARY_ITERATE;
+                return;
+            }
+            fill[index] = BOUNDARY_SPLIT;
+            const uint32_t half = size / 2;
+            const bool right = t.x + half < w, below = t.y + half < h;
+            sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed, sycl::memory_scope::device> slots(*next_count);
+            uint32_t slot = slots.fetch_add(1u + right + below + (right && below));
+            next[slot++] = BoundaryTile{ t.x, t.y };
+            if (right) next[slot++] = BoundaryTile{ t.x + half, t.y };
+            if (below) next[slot++] = BoundaryTile{ t.x, t.y + half };
+            if (right && below) next[slot] = BoundaryTile{ t.x + half, t.y + half };
+            }));
+        ctx.record("interior", q.parallel_for(sycl::range<2>{ count, size * size }, [=](auto i) {
+            const uint32_t action = fill[i[0]];
+            if (action == BOUNDARY_SPLIT) return;
+            const BoundaryTile t = tiles[i[0]];
+            const uint32_t x = t.x + static_cast<uint32_t>(i[1]) % size, y = t.y + static_cast<uint32_t>(i[1]) / size;
+            const uint32_t x1 = std::min(t.x + size, w) - 1, y1 = std::min(t.y + size, h) - 1;
+            if (x <= t.x || x >= x1 || y <= t.y || y >= y1) return;
+            out[y * w + x] = action == BOUNDARY_ITERATE ? render_pixel(grid, poly, lut, x, y, iterations) : action;
+            }));
+        if (!split) break;
+        uint32_t host_count;
+        q.memcpy(&host_count, next_count, sizeof(uint32_t)).wait();
+        count = host_count;
+        std::swap(tiles, next);
+    }
+}
+
+// Mariani-Silver subdivision: squares of BOUNDARY_TILE pixels iterate only their border, and when the whole
+// border has one colour the interior is filled without iterating. Other squares are split into quarters down
+// to BOUNDARY_MIN_TILE, whose interiors are iterated. Each level costs one host round trip for the tile count.
+static void newton_boundary(RenderContext& ctx, const View& view) {
+    dispatch(view, [&](auto n, auto t) {
+        render_boundary<decltype(n)::value, decltype(t)>(ctx, view);
+        });
+}
+
+template <size_t N, typename T>
+static void render_shifted(RenderContext& ctx, const View& view, const ptrdiff_t dx, const ptrdiff_t dy) {
+    const ptrdiff_t w = static_cast<ptrdiff_t>(ctx.width), h = static_cast<ptrdiff_t>(ctx.height);
+    const Polynomial<N, T> poly = make_polynomial<N, T>(view);
+    const Grid<T> grid = make_grid<T>(view);
+    const PaletteLut lut = make_palette<T>(view);
+    const uint32_t iterations = static_cast<uint32_t>(view.iterations);
+    const uint32_t* in = ctx.back_image;
+    uint32_t* out = ctx.image;
+    ctx.record("shift", ctx.q.parallel_for(sycl::range<2>{ ctx.height, ctx.width }, [=](auto i) {
+        const ptrdiff_t y = static_cast<ptrdiff_t>(i[0]), x = static_cast<ptrdiff_t>(i[1]);
+        const ptrdiff_t sy = y + dy, sx = x + dx;
+        if (sy >= 0 && sy < h && sx >= 0 && sx < w) out[y * w + x] = in[sy * w + sx];
+        else out[y * w + x] = render_pixel(grid, poly, lut, i[1], i[0], iterations);
+        }));
+}
+
+// Moves the current image so that new pixel (x, y) takes old pixel (x + dx, y + dy) and renders only the
+// pixels that scrolled in from outside the old frame.
+static void newton_shifted(RenderContext& ctx, View view, const ptrdiff_t dx, const ptrdiff_t dy) {
+    view.precision = supported_precision(ctx.q.get_device(), view.precision);
+    ctx.reserve_back_image();
+    std::swap(ctx.image, ctx.back_image);
+    dispatch(view, [&](auto n, auto t) {
+        render_shifted<decltype(n)::value, decltype(t)>(ctx, view, dx, dy);
+        });
+    if (ctx.stage_output) ctx.record("staging", ctx.q.memcpy(ctx.staging, ctx.image, ctx.pixel_count() * sizeof(uint32_t)), true);
+    ctx.q.wait();
+}
+
+// True when `to` is `from` translated by a whole, non-zero number of pixels; the offset is returned in dx, dy.
+static bool pan_offset(const View& from, const View& to, ptrdiff_t& dx, ptrdiff_t& dy) {
+    if (!same_roots(from, to) || from.precision != to.precision || from.palette != to.palette) return false;
+    // Scrolled-in pixels are rendered with one sample each.
+    if (from.antialias != Antialias::Off || to.antialias != Antialias::Off) return false;
+    if (from.unit != to.unit || from.iterations != to.iterations) return false;
+    const double fx = (to.left - from.left) / to.unit;
+    const double fy = (from.top - to.top) / to.unit;
+    const double rx = std::round(fx), ry = std::round(fy);
+    if (std::abs(fx - rx) > 1e-3 || std::abs(fy - ry) > 1e-3) return false;
+    dx = static_cast<ptrdiff_t>(rx);
+    dy = static_cast<ptrdiff_t>(ry);
+    return dx != 0 || dy != 0;
+}
+#else
+template <size_t N> class PipelinedNewton;
+template <size_t N> class PipelinedWriter;
+template <size_t N> class PixelPipeId;
+// One pipe per root count, as every pipe connects exactly one writing and one reading kernel.
+template <size_t N>
+using PixelPipe = sycl::ext::intel::pipe<PixelPipeId<N>, uint32_t, FPGA_PIPE_DEPTH>;
+
+// FPGA engine. A single_task walks the pixels in a loop pipelined at an initiation interval of one, with the Newton
+// iteration unrolled into FPGA_NEWTON_DEPTH hardware stages, so a new pixel enters the datapath every clock. Its
+// colours stream through a pipe to a second kernel that owns the image stores, which keeps global memory out of
+// the datapath. Steps past the view's budget or its convergence pass the iterate through unchanged.
+template <size_t N>
+static void newton_pipelined(RenderContext& ctx, const View& view) {
+    const size_t w = ctx.width, total = ctx.pixel_count();
+    const Polynomial<N, float> poly = make_polynomial<N, float>(view);
+    const Grid<float> grid = make_grid<float>(view);
+    const PaletteLut lut = make_palette<float>(view);
+    const uint32_t iterations = static_cast<uint32_t>(view.iterations);
+    uint32_t* out = ctx.image;
+    // Each end of the pipe stalls until the other runs, so the producer is queued on a queue of its own.
+    ctx.record("pipelined", ctx.reserve_side_queue().single_task<PipelinedNewton<N>>([=]() {
+        size_t x = 0, y = 0;
+        [[intel::initiation_interval(1)]]
+        for (size_t p = 0; p < total; ++p) {
+            Complex<float> v = pixel_to_complex(grid, x, y);
+            float hyp, last = 0.0f;
+            size_t root = 0;
+            uint32_t count = 0;
+            bool running = true;
+#pragma unroll
+            for (uint32_t k = 0; k < FPGA_NEWTON_DEPTH; ++k) {
+                const Complex<float> next = newton_step(v, poly);
+                const Complex<float> step = next - v;
+                const size_t nearest = nearest_root(next, poly, hyp);
+                if (running && k < iterations) {
+                    v = next;
+                    root = nearest;
+                    ++count;
+                    last = norm2(step);
+                    running = !has_converged(step, hyp);
+                }
+            }
+            // Taken once per pixel rather than in every stage.
+            const float fraction = lut.smooth && !running ? last_step_fraction(lut.log_tolerance, last) : 1.0f;
+            PixelPipe<N>::write(palette_color(lut, count == 0 ? closest_root(v, poly) : root, count, fraction, iterations));
+            if (++x == w) {
+                x = 0;
+                ++y;
+            }
+        }
+        }));
+    ctx.record("pipelined-writer", ctx.q.single_task<PipelinedWriter<N>>([=]() [[intel::kernel_args_restrict]] {
+        [[intel::initiation_interval(1)]]
+        for (size_t p = 0; p < total; ++p) out[p] = PixelPipe<N>::read();
+        }));
+}
+#endif
+
+// Queues one frame and, unless ctx.stage_output is cleared, its copy into ctx.staging; the returned event
+// completes once the frame is ready where it was asked for. The queue must be in-order. Only the fused engine
+// renders in blocks; the others always produce the full-resolution image. Precisions the device lacks fall
+// back as in supported_precision, and supersampled views are always drawn by the fused engine in full.
+// FPGA builds draw every view with the pipelined engine, in float and one sample per pixel; fpga_options() refuses
+// views without FPGA_ROOT_COUNT roots or with more than FPGA_NEWTON_DEPTH iterations.
+static sycl::event submit_newton(
+    RenderContext& ctx, const Engine engine, const IterateStorage storage, View view,
+    const size_t block = 1, const bool refine = false
+) {
+#if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
+    view.precision = Precision::Float;
+    dispatch_roots<float>(view.root_count, [&](auto n, auto) {
+        newton_pipelined<decltype(n)::value>(ctx, view);
+        });
+#else
+    view.precision = supported_precision(ctx.q.get_device(), view.precision);
+    const bool supersampled = view.antialias != Antialias::Off;
+    switch (supersampled ? Engine::Fused : engine) {
+    case Engine::Fused:
+        dispatch(view, [&](auto n, auto t) {
+            newton_fused<decltype(n)::value, decltype(t)>(ctx, view, supersampled ? 1 : block, refine && !supersampled);
+            });
+        break;
+    case Engine::MultiPass:
+        newton_multi_pass(ctx, storage, view);
+        break;
+    case Engine::Tiled:
+        newton_tiled(ctx, view);
+        break;
+    case Engine::Boundary:
+        newton_boundary(ctx, view);
+        break;
+    case Engine::Simd:
+        // The lane groups are float-only; other precisions go through the fused engine.
+        if (view.precision != Precision::Float) {
+            dispatch(view, [&](auto n, auto t) {
+                newton_fused<decltype(n)::value, decltype(t)>(ctx, view, 1, false);
+                });
+        }
+        else dispatch_roots<float>(view.root_count, [&](auto n, auto) {
+            newton_simd<decltype(n)::value>(ctx, view);
+            });
+        break;
+    case Engine::Pipelined:
+        // Its stages are only built for FPGA; other builds draw it as the fused engine.
+        dispatch(view, [&](auto n, auto t) {
+            newton_fused<decltype(n)::value, decltype(t)>(ctx, view, 1, false);
+            });
+        break;
+    }
+#endif
+    if (!ctx.stage_output) return ctx.q.ext_oneapi_submit_barrier();
+    return ctx.record("staging", ctx.q.memcpy(ctx.staging, ctx.image, ctx.pixel_count() * sizeof(uint32_t)), true);
+}
+
+// Renders one frame into ctx.staging, or only into ctx.image when stage_output is cleared.
+static void newton(
+    RenderContext& ctx, const Engine engine, const IterateStorage storage, const View& view,
+    const size_t block = 1, const bool refine = false
+) {
+    submit_newton(ctx, engine, storage, view, block, refine);
+    ctx.q.wait();
+}
+
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+// One root-drag frame in float. Priming iterates every pixel from its seed and keeps its last iterate and packed
+// count; later frames take at most WARM_STEPS steps from the kept iterates towards the moved roots, so every
+// pixel stays in the basin it had when primed and keeps its iteration count.
+template <size_t N>
+static void newton_warm(RenderContext& ctx, const View& view, const bool prime) {
+    typedef FloatIterate::type iterate;
+    const size_t w = ctx.width;
+    const Polynomial<N, float> poly = make_polynomial<N, float>(view);
+    const Grid<float> grid = make_grid<float>(view);
+    const PaletteLut lut = make_palette<float>(view);
+    const uint32_t iterations = static_cast<uint32_t>(view.iterations);
+    const uint32_t steps = prime ? iterations : std::min<uint32_t>(WARM_STEPS, iterations);
+    const uint32_t one = 1u << COUNT_FRACTION_BITS;
+    iterate* vec = static_cast<iterate*>(ctx.iterates);
+    uint32_t* count = ctx.counts;
+    uint32_t* out = ctx.image;
+    ctx.record(prime ? "prime" : "warm", ctx.q.parallel_for(sycl::range<2>{ ctx.height, w }, [=](auto i) {
+        const size_t index = i[0] * w + i[1];
+        Complex<float> v = prime ? pixel_to_complex(grid, i[1], i[0]) : FloatIterate::decode(vec[index], 1.0f);
+        float fraction = 1.0f, hyp;
+        size_t root = 0;
+        uint32_t taken = 0;
+        while (taken < steps) {
+            const Complex<float> next = newton_step(v, poly);
+            const Complex<float> step = next - v;
+            v = next;
+            ++taken;
+            root = track_root(v, poly, root, hyp);
+            if (has_converged(step, hyp)) {
+                if (lut.smooth) fraction = last_step_fraction(lut.log_tolerance, norm2(step));
+                break;
+            }
+        }
+        if (taken == 0) root = closest_root(v, poly);
+        vec[index] = FloatIterate::encode(v, 1.0f);
+        if (prime) count[index] = taken << COUNT_FRACTION_BITS | static_cast<uint32_t>(fraction * (one - 1) + 0.5f);
+        const uint32_t c = count[index];
+        out[index] = palette_color(lut, root, c >> COUNT_FRACTION_BITS, static_cast<float>(c & (one - 1)) / (one - 1), iterations);
+        }));
+}
+
+// Whether the kept iterates can be warm-started for `view`: the same grid, root count and iteration budget, and no
+// root has drifted more than WARM_DRIFT_PIXELS from where it was primed. Basin boundaries follow the roots, so the
+// pixels left in a stale basin grow with that drift.
+static bool warm_start_applies(const RenderContext& ctx, const View& view) {
+    const View& last = ctx.warm_view;
+    const View& primed = ctx.warm_primed;
+    if (!ctx.warm || last.unit != view.unit || last.left != view.left || last.top != view.top) return false;
+    if (last.root_count != view.root_count || last.iterations != view.iterations) return false;
+    for (size_t k = 0; k < view.root_count; ++k) {
+        if (std::abs(view.roots[k] - primed.roots[k]) > WARM_DRIFT_PIXELS * view.unit) return false;
+    }
+    return true;
+}
+
+// Renders a frame of a root drag from the previous frame's iterates, priming them first when they do not apply.
+// Only float and half views without antialiasing are drawn this way; the result is a preview that the caller
+// replaces with a full render once the drag ends or the root rests for WARM_IDLE_MS.
+static void newton_root_drag(RenderContext& ctx, const View& view) {
+    ctx.reserve_iterates(IterateStorage::Float);
+    const bool prime = !warm_start_applies(ctx, view);
+    dispatch_roots<float>(view.root_count, [&](auto n, auto) {
+        newton_warm<decltype(n)::value>(ctx, view, prime);
+        });
+    ctx.warm = true;
+    ctx.warm_view = view;
+    if (prime) ctx.warm_primed = view;
+    if (ctx.stage_output) ctx.record("staging", ctx.q.memcpy(ctx.staging, ctx.image, ctx.pixel_count() * sizeof(uint32_t)), true);
+    ctx.q.wait();
+}
+
+// One frame of a sweep batch as the batched kernel reads it.
+template <size_t N, typename T>
+struct SweepFrame {
+    Polynomial<N, T> poly;
+    Grid<T> grid;
+    uint32_t iterations;
+};
+
+// Renders `count` frames of ctx.width x h pixels, stacked in ctx.image, with one launch whose first dimension is
+// the frame. The frames share their root count, precision, palette and supersampling.
+template <size_t N, typename T>
+static void render_sweep(RenderContext& ctx, const View* views, const size_t count, const size_t h) {
+    const size_t w = ctx.width;
+    std::vector<SweepFrame<N, T>> frames;
+    for (size_t f = 0; f < count; ++f) frames.push_back(SweepFrame<N, T>{ make_polynomial<N, T>(views[f]), make_grid<T>(views[f]), static_cast<uint32_t>(views[f].iterations) });
+    const size_t bytes = count * sizeof(SweepFrame<N, T>);
+    ctx.reserve_frame_params(bytes);
+    // Waited on since `frames` goes out of scope; it is tiny, and the previous batch has finished by now.
+    ctx.record("sweep frames", ctx.q.memcpy(ctx.frame_params, frames.data(), bytes), true).wait();
+    const SweepFrame<N, T>* params = static_cast<const SweepFrame<N, T>*>(ctx.frame_params);
+    const PaletteLut lut = make_palette<T>(views[0]);
+    const uint32_t side = antialias_side(views[0].antialias);
+    uint32_t* out = ctx.image;
+    ctx.record("sweep", ctx.q.parallel_for(sycl::range<3>{ count, h, w }, [=](auto i) {
+        const SweepFrame<N, T>& frame = params[i[0]];
+        uint32_t n, saturated;
+        out[(i[0] * h + i[1]) * w + i[2]] = side > 1
+            ? render_supersampled(frame.grid, frame.poly, lut, i[2], i[1], side, false, frame.iterations, n, saturated)
+            : render_pixel(frame.grid, frame.poly, lut, i[2], i[1], frame.iterations);
+        }));
+}
+
+// Queues a sweep batch and its copy into ctx.staging, in the precision of the first view. The adaptive
+// supersampling pass is not run on sweeps.
+static sycl::event submit_sweep(RenderContext& ctx, const View* views, const size_t count, const size_t h) {
+    View view = views[0];
+    view.precision = supported_precision(ctx.q.get_device(), view.precision);
+    dispatch(view, [&](auto n, auto t) {
+        render_sweep<decltype(n)::value, decltype(t)>(ctx, views, count, h);
+        });
+    return ctx.record("staging", ctx.q.memcpy(ctx.staging, ctx.image, count * ctx.width * h * sizeof(uint32_t)), true);
+}
+#else
+// FPGA builds have no batched kernel: fpga_options() makes sweep and tile batches one frame each, and that frame
+// is drawn like any other.
+static sycl::event submit_sweep(RenderContext& ctx, const View* views, const size_t, const size_t) {
+    return submit_newton(ctx, Engine::Pipelined, IterateStorage::Float, views[0]);
+}
+#endif
+
+// Splits each frame into row bands, one per device, sized by the rows per millisecond each device achieved on
+// recent frames. Every device renders its band into its own context and the bands are gathered on the host.
+struct MultiDeviceRenderer {
+    struct Share {
+        sycl::queue q;
+        RenderContext ctx;
+        size_t first_row = 0;
+        double rows_per_ms = 0.0;
+        double last_ms = 0.0;
+
+        Share(const sycl::device& device, const size_t width, const size_t rows)
+            : q(device, exception_handler, sycl::property::queue::in_order()), ctx(q, width, rows) {}
+    };
+
+    std::vector<std::unique_ptr<Share>> shares;
+    size_t width = 0, height = 0;
+
+    // Every GPU and CPU visible through the primary device's backend, plus a CPU from any backend if that one
+    // exposes none. Backends often expose the same hardware twice, so other duplicates are skipped.
+    static std::vector<sycl::device> render_devices(const sycl::device& primary) {
+        std::vector<sycl::device> devices;
+        bool has_cpu = false;
+        for (const sycl::device& d : sycl::device::get_devices()) {
+            if (d.get_backend() != primary.get_backend() || !(d.is_gpu() || d.is_cpu())) continue;
+            devices.push_back(d);
+            has_cpu = has_cpu || d.is_cpu();
+        }
+        if (!has_cpu) {
+            for (const sycl::device& d : sycl::device::get_devices()) {
+                if (!d.is_cpu()) continue;
+                devices.push_back(d);
+                break;
+            }
+        }
+        return devices;
+    }
+
+    MultiDeviceRenderer(const sycl::device& primary, const size_t w, const size_t h) : width(w), height(h) {
+        const std::vector<sycl::device> devices = render_devices(primary);
+        const size_t count = std::min(devices.size(), h);
+        for (size_t i = 0; i < count; ++i) {
+            const size_t first = h * i / count, last = h * (i + 1) / count;
+            shares.push_back(std::make_unique<Share>(devices[i], w, last - first));
+            shares.back()->first_row = first;
+        }
+    }
+
+    size_t rows(const size_t i) const {
+        return shares[i]->ctx.height;
+    }
+
+    // Resizes the bands when the measured throughput says the split is off by more than a few rows.
+    void rebalance() {
+        double total = 0.0;
+        for (const auto& share : shares) total += share->rows_per_ms;
+        if (total <= 0.0) return;
+        std::vector<size_t> target(shares.size());
+        size_t assigned = 0;
+        for (size_t i = 0; i < shares.size(); ++i) {
+            const size_t remaining = shares.size() - i - 1;
+            size_t r = i + 1 == shares.size()
+                ? height - assigned
+                : static_cast<size_t>(height * shares[i]->rows_per_ms / total) / 8 * 8;
+            r = std::max<size_t>(std::min(r, height - assigned - remaining), 1);
+            target[i] = r;
+            assigned += r;
+        }
+        bool moved = false;
+        for (size_t i = 0; i < shares.size(); ++i) {
+            const size_t diff = target[i] > rows(i) ? target[i] - rows(i) : rows(i) - target[i];
+            moved = moved || diff > std::max<size_t>(height / 20, 8);
+        }
+        if (!moved) return;
+        size_t first = 0;
+        for (size_t i = 0; i < shares.size(); ++i) {
+            shares[i]->ctx.resize(width, target[i]);
+            shares[i]->first_row = first;
+            first += target[i];
+        }
+    }
+
+    void render(uint32_t* out, const Engine engine, const IterateStorage storage, const View& view) {
+        std::vector<sycl::event> done;
+        const uint64_t start = SDL_GetPerformanceCounter();
+        for (const auto& share : shares) {
+            View band = view;
+            band.top = view.top - view.unit * static_cast<double>(share->first_row);
+            done.push_back(submit_newton(share->ctx, engine, storage, band));
+        }
+        // Poll rather than wait in order so each device's completion time is observed separately.
+        std::vector<bool> finished(shares.size(), false);
+        for (size_t remaining = shares.size(); remaining > 0;) {
+            for (size_t i = 0; i < shares.size(); ++i) {
+                if (finished[i]) continue;
+                if (done[i].get_info<sycl::info::event::command_execution_status>() != sycl::info::event_command_status::complete) continue;
+                finished[i] = true;
+                --remaining;
+                Share& share = *shares[i];
+                share.last_ms = std::max(1e-3, (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency());
+                const double rate = rows(i) / share.last_ms;
+                share.rows_per_ms = share.rows_per_ms == 0.0 ? rate : share.rows_per_ms * 0.5 + rate * 0.5;
+                memcpy(out + share.first_row * width, share.ctx.staging, share.ctx.pixel_count() * sizeof(uint32_t));
+            }
+            if (remaining > 0) std::this_thread::yield();
+        }
+        rebalance();
+    }
+};
+
+// Keeps up to `depth` frames in flight, each rendering into its own context, so the device works on the next
+// frame while the host uploads and presents the previous one. Nothing here blocks on the device.
+struct FramePipeline {
+    struct Slot {
+        RenderContext ctx;
+        View view{};
+        sycl::event done;
+        uint64_t generation = 0;
+        bool busy = false;
+
+        Slot(sycl::queue& q, const size_t width, const size_t height, const IterateStorage storage) : ctx(q, width, height) {
+            ctx.reserve_frame(storage);
+        }
+    };
+
+    std::vector<std::unique_ptr<Slot>> slots;
+    uint64_t submitted = 0, presented = 0;
+    size_t dropped = 0;
+
+    // Frames must use `storage`; the pipeline is rebuilt when it changes.
+    FramePipeline(sycl::queue& q, const size_t depth, const size_t width, const size_t height, const IterateStorage storage) {
+        for (size_t i = 0; i < depth; ++i) slots.push_back(std::make_unique<Slot>(q, width, height, storage));
+    }
+
+    // Returns false when every slot is still in flight; the caller keeps the view and retries next loop.
+    bool submit(const Engine engine, const IterateStorage storage, const View& view) {
+        for (const auto& slot : slots) {
+            if (slot->busy) continue;
+            slot->view = view;
+            slot->done = submit_newton(slot->ctx, engine, storage, view);
+            slot->generation = ++submitted;
+            slot->busy = true;
+            return true;
+        }
+        return false;
+    }
+
+    size_t in_flight() const {
+        size_t count = 0;
+        for (const auto& slot : slots) count += slot->busy;
+        return count;
+    }
+
+    // Returns the newest finished frame, or nullptr. Finished frames older than it are stale and dropped. The
+    // slot is released immediately, so the frame must be uploaded before the next submit.
+    const Slot* poll() {
+        Slot* newest = nullptr;
+        for (const auto& slot : slots) {
+            if (!slot->busy) continue;
+            if (slot->done.get_info<sycl::info::event::command_execution_status>() != sycl::info::event_command_status::complete) continue;
+            slot->busy = false;
+            if (newest != nullptr && newest->generation > slot->generation) {
+                ++dropped;
+                continue;
+            }
+            if (newest != nullptr) ++dropped;
+            newest = slot.get();
+        }
+        if (newest == nullptr || newest->generation <= presented) return nullptr;
+        presented = newest->generation;
+        return newest;
+    }
+};
+
+// Chooses the iteration budget of frames rendered during interaction so that they fit a frame-time target.
+// Cost is modelled per iteration actually performed: lowering the budget by one only saves work on samples that
+// hit it, so when few pixels run out of iterations the budget stays high and only resolution can help.
+struct IterationGovernor {
+    size_t iterations = 0;
+
+    // Budget for the next interactive frame given the full-quality count.
+    size_t budget(const size_t full) const {
+        return iterations == 0 ? full : std::min(iterations, full);
+    }
+
+    // Feeds back one frame rendered with `used` iterations in `ms`. `work` is the number of iterations executed
+    // and `saturated` the number of samples that used all of them.
+    void update(const double target_ms, const double ms, const size_t used, const size_t full,
+        const uint64_t work, const uint64_t saturated) {
+        if (work == 0 || ms <= 0.0) return;
+        const double wanted = static_cast<double>(work) * target_ms / ms;
+        double next = static_cast<double>(used);
+        if (saturated > 0) next += (wanted - static_cast<double>(work)) / static_cast<double>(saturated);
+        else if (wanted >= static_cast<double>(work)) next = static_cast<double>(full);
+        // Halfway steps keep one noisy frame from swinging the budget.
+        next = (next + static_cast<double>(used)) / 2.0;
+        iterations = static_cast<size_t>(std::round(std::min(static_cast<double>(full), std::max<double>(GOVERNOR_MIN_ITERATIONS, next))));
+    }
+};
+
+// Paces the interactive loop. Held keys move the view at a rate per second of real time rather than per loop, in
+// whole steps whose remainders carry over to later frames. Nothing is presented unless a frame was drawn, so the
+// loop blocks for input instead, only briefly while rendering is still pending.
+struct RenderScheduler {
+    std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+    double seconds = 0.0;
+    double carry[3] = {};
+    int wait_ms = 0;
+
+    // Measures the time since the previous frame; a stall, e.g. waiting for input, counts as MAX_FRAME_SECONDS at
+    // most so that held keys do not jump the view.
+    void begin_frame() {
+        const auto now = std::chrono::steady_clock::now();
+        seconds = std::min(std::chrono::duration<double>(now - last).count(), MAX_FRAME_SECONDS);
+        last = now;
+    }
+
+    // Whole steps `axis` moves this frame while held in direction `sign`, which is -1, 0 or 1, at `rate` per second.
+    int steps(const size_t axis, const int sign, const double rate) {
+        if (sign == 0) {
+            carry[axis] = 0.0;
+            return 0;
+        }
+        carry[axis] += sign * rate * seconds;
+        const double whole = std::trunc(carry[axis]);
+        carry[axis] -= whole;
+        return static_cast<int>(whole);
+    }
+
+    // Fetches the next queued event; the first call of a frame blocks for up to wait_ms.
+    bool next_event(SDL_Event& event) {
+        const int wait = wait_ms;
+        wait_ms = 0;
+        return (wait > 0 ? SDL_WaitEventTimeout(&event, wait) : SDL_PollEvent(&event)) == 1;
+    }
+
+    // Chooses how long the next frame waits for input before it renders.
+    void end_frame(const bool presented, const bool pending) {
+        wait_ms = presented ? 0 : pending ? BUSY_WAIT_MS : IDLE_WAIT_MS;
+    }
+
+    // Whether input is queued, which makes any further pass for the current view stale.
+    static bool input_pending() {
+        SDL_PumpEvents();
+        return SDL_HasEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+    }
+};
+
+#if FPGA_EMULATOR
+// Intel extension: FPGA emulator selector on systems without FPGA card.
+const auto device_selector = sycl::ext::intel::fpga_emulator_selector_v;
+#elif FPGA_SIMULATOR
+// Intel extension: FPGA simulator selector on systems without FPGA card.
+const auto device_selector = sycl::ext::intel::fpga_simulator_selector_v;
+#elif FPGA_HARDWARE
+// Intel extension: FPGA selector on systems with FPGA card.
+const auto device_selector = sycl::ext::intel::fpga_selector_v;
+#else
+// The default device selector will select the most performant device.
+const auto device_selector = sycl::default_selector_v;
+#endif
+
+// Zoom is tracked as an integer level so that returning to a level reproduces the same unit exactly.
+static double zoom_width(const int level) {
+    return UNIT_WIDTH * std::pow(ZOOM_STEP, level);
+}
+
+static double coords_to_pix_x(const double x, const double left, const double unit_width, const double width) {
+    return (x - left) / unit_width * width;
+}
+
+static double coords_to_pix_y(const double y, const double top, const double unit_height, const double height) {
+    return (top - y) / unit_height * height;
+}
+
+static double pix_to_coords_x(const double x, const double left, const double unit_width, const double width) {
+    return x / width * unit_width + left;
+}
+
+static double pix_to_coords_y(const double y, const double top, const double unit_height, const double height) {
+    return top - y / height * unit_height;
+}
+
+static size_t scaled_size(const int size, const double scale) {
+    return std::max<size_t>(1, static_cast<size_t>(std::llround(size * scale)));
+}
+
+static bool is_in_range(const double x1, const double y1, const double x2, const double y2) {
+    return std::abs(x1 - x2) < 5.0 && std::abs(y1 - y2) < 5.0;
+}
+
+struct Job {
+    View view;
+    std::string output;
+};
+
+struct Keyframe {
+    size_t frame;
+    View view;
+};
+
+struct Options {
+    bool headless = false;
+    bool benchmark = false;
+    std::string benchmark_output;
+    // Directory of golden images for --verify; with --record they are rendered and written first.
+    std::string verify;
+    bool record = false;
+    std::string trace;
+    bool auto_precision = true;
+    Palette palette = Palette::Classic;
+    Antialias antialias = Antialias::Off;
+    size_t width = WIDTH, height = HEIGHT;
+    bool size_given = false;
+#if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
+    Engine engine = Engine::Pipelined;
+#else
+    Engine engine = Engine::Fused;
+#endif
+    bool engine_given = false;
+    IterateStorage storage = IterateStorage::Float;
+    std::vector<Job> jobs;
+    // A sweep renders every frame between its keyframes into one PPM stream, `batch` frames per kernel.
+    std::vector<Keyframe> keyframes;
+    std::string sweep_output;
+    size_t batch = SWEEP_BATCH;
+    // A poster renders the one job's view at width x height in row bands, streaming them to poster_output.
+    std::string poster_output;
+    // Port of the HTTP tile service, 0 when not serving, and the directory its tiles persist in, if any.
+    int serve_port = 0;
+    std::string tile_cache;
+};
+
+static bool parse_complex(const std::string& text, complex& value) {
+    std::istringstream in(text);
+    float re, im;
+    char comma;
+    if (!(in >> re >> comma >> im) || comma != ',') return false;
+    value = complex(re, im);
+    return true;
+}
+
+static bool parse_precision(const std::string& name, Precision& precision) {
+    for (const Precision p : { Precision::Half, Precision::Float, Precision::Double, Precision::DoubleFloat }) {
+        if (name != precision_name(p)) continue;
+        precision = p;
+        return true;
+    }
+    return false;
+}
+
+static bool parse_palette(const std::string& name, Palette& palette) {
+    for (const Palette p : { Palette::Classic, Palette::Smooth, Palette::Pastel, Palette::Bands, Palette::Index }) {
+        if (name != palette_name(p)) continue;
+        palette = p;
+        return true;
+    }
+    return false;
+}
+
+static bool parse_antialias(const std::string& name, Antialias& antialias) {
+    for (const Antialias a : { Antialias::Off, Antialias::Grid2, Antialias::Grid3, Antialias::Grid4, Antialias::Adaptive }) {
+        if (name != antialias_name(a)) continue;
+        antialias = a;
+        return true;
+    }
+    return false;
+}
+
+// Reads the view fields of a job or keyframe line: left top unit_width a.re a.im b.re b.im c.re c.im iterations
+// [re im]..., where the optional trailing pairs add roots up to MAX_ROOTS. unit_width is the width of the whole
+// image in the complex plane.
+static bool read_view(
+    std::istringstream& in, const std::string& path, const size_t number, const size_t width, const Precision precision, View& view
+) {
+    double unit_width;
+    float ar, ai, br, bi, cr, ci;
+    if (!(in >> view.left >> view.top >> unit_width >> ar >> ai >> br >> bi >> cr >> ci >> view.iterations)) {
+        std::cerr << path << ":" << number << ": malformed line" << std::endl;
+        return false;
+    }
+    view.unit = unit_width / static_cast<double>(width);
+    view.precision = precision;
+    view.roots[0] = complex(ar, ai);
+    view.roots[1] = complex(br, bi);
+    view.roots[2] = complex(cr, ci);
+    view.root_count = 3;
+    float re, im;
+    while (in >> re >> im) {
+        if (view.root_count == MAX_ROOTS) {
+            std::cerr << path << ":" << number << ": more than " << MAX_ROOTS << " roots" << std::endl;
+            return false;
+        }
+        view.roots[view.root_count++] = complex(re, im);
+    }
+    return true;
+}
+
+// Job file lines: the output path followed by the view fields of read_view. Blank lines and lines starting with
+// '#' are skipped; a file without any job is an error.
+static bool read_jobs(const std::string& path, const size_t width, const Precision precision, std::vector<Job>& jobs) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Cannot open job file " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    for (size_t number = 1; std::getline(file, line); ++number) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream in(line);
+        Job job{};
+        if (!(in >> job.output)) {
+            std::cerr << path << ":" << number << ": malformed line" << std::endl;
+            return false;
+        }
+        if (!read_view(in, path, number, width, precision, job.view)) return false;
+        jobs.push_back(job);
+    }
+    if (jobs.empty()) std::cerr << path << ": no jobs" << std::endl;
+    return !jobs.empty();
+}
+
+// Keyframe file lines: a frame number followed by the view fields of read_view, skipping blank and '#' lines as
+// job files do. The first keyframe is frame 0, frame numbers increase and all keyframes have the same roots count.
+static bool read_keyframes(const std::string& path, const size_t width, const Precision precision, std::vector<Keyframe>& keys) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Cannot open keyframe file " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    for (size_t number = 1; std::getline(file, line); ++number) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream in(line);
+        Keyframe key{};
+        if (!(in >> key.frame)) {
+            std::cerr << path << ":" << number << ": malformed line" << std::endl;
+            return false;
+        }
+        if (!read_view(in, path, number, width, precision, key.view)) return false;
+        if (keys.empty() ? key.frame != 0 : key.frame <= keys.back().frame || key.view.root_count != keys.back().view.root_count) {
+            std::cerr << path << ":" << number << ": keyframe out of order or with a different root count" << std::endl;
+            return false;
+        }
+        keys.push_back(key);
+    }
+    if (keys.empty()) std::cerr << path << ": no keyframes" << std::endl;
+    return !keys.empty();
+}
+
+static bool parse_engine(const std::string& name, Engine& engine) {
+    for (const Engine e : { Engine::Fused, Engine::MultiPass, Engine::Tiled, Engine::Simd, Engine::Boundary, Engine::Pipelined }) {
+        if (name != engine_name(e)) continue;
+        engine = e;
+        return true;
+    }
+    return false;
+}
+
+static bool parse_options(const int argc, char* argv[], Options& options) {
+    const complex defaults[] = { -2.0f + 1.0if, 2.0f + 2.0if, -1.0f - 2.0if };
+    View view = make_view(defaults, 3, 0.0, -5.0, 4.0, ITERATION_COUNT, Precision::Float);
+    std::vector<complex> roots;
+    double unit_width = UNIT_WIDTH;
+    std::string output, jobs, sweep;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        const std::string value = has_value ? argv[i + 1] : "";
+        bool ok = true;
+        if (arg == "--headless") {
+            options.headless = true;
+            continue;
+        }
+        else if (arg == "--benchmark") {
+            options.headless = options.benchmark = true;
+            continue;
+        }
+        else if (arg == "--record") {
+            options.record = true;
+            continue;
+        }
+        else if (arg == "--size") {
+            char x;
+            std::istringstream in(value);
+            ok = options.size_given = static_cast<bool>(in >> options.width >> x >> options.height) && x == 'x' && options.width > 0 && options.height > 0;
+        }
+        else if (arg == "--view") {
+            char c1, c2;
+            std::istringstream in(value);
+            ok = static_cast<bool>(in >> view.left >> c1 >> view.top >> c2 >> unit_width) && c1 == ',' && c2 == ',';
+        }
+        else if (arg == "--a") ok = parse_complex(value, view.roots[0]);
+        else if (arg == "--b") ok = parse_complex(value, view.roots[1]);
+        else if (arg == "--c") ok = parse_complex(value, view.roots[2]);
+        else if (arg == "--root") {
+            complex root;
+            ok = parse_complex(value, root) && roots.size() < MAX_ROOTS;
+            roots.push_back(root);
+        }
+        else if (arg == "--precision") {
+            options.auto_precision = value == "auto";
+            ok = options.auto_precision || parse_precision(value, view.precision);
+        }
+        else if (arg == "--palette") ok = parse_palette(value, options.palette);
+        else if (arg == "--antialias") ok = parse_antialias(value, options.antialias);
+        else if (arg == "--iterations") ok = static_cast<bool>(std::istringstream(value) >> view.iterations);
+        else if (arg == "--engine") ok = options.engine_given = parse_engine(value, options.engine);
+        else if (arg == "--output") output = value;
+        else if (arg == "--verify") {
+            options.verify = value;
+            options.headless = true;
+        }
+        else if (arg == "--benchmark-output") options.benchmark_output = value;
+        else if (arg == "--trace") options.trace = value;
+        else if (arg == "--jobs") jobs = value;
+        else if (arg == "--sweep") {
+            sweep = value;
+            options.headless = true;
+        }
+        else if (arg == "--poster") {
+            options.poster_output = value;
+            options.headless = true;
+        }
+        else if (arg == "--serve") {
+            ok = static_cast<bool>(std::istringstream(value) >> options.serve_port) && options.serve_port > 0 && options.serve_port < 65536;
+            options.headless = true;
+        }
+        else if (arg == "--tile-cache") options.tile_cache = value;
+        else if (arg == "--batch") ok = static_cast<bool>(std::istringstream(value) >> options.batch) && options.batch > 0;
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+        if (!ok || !has_value) {
+            std::cerr << "Invalid value for " << arg << std::endl;
+            return false;
+        }
+        ++i;
+    }
+    if (!sweep.empty()) {
+        options.sweep_output = output.empty() ? "sweep.ppm" : output;
+        return read_keyframes(sweep, options.width, view.precision, options.keyframes);
+    }
+    if (!jobs.empty()) return read_jobs(jobs, options.width, view.precision, options.jobs);
+    if (output.empty()) output = "fractal.bmp";
+    // --root replaces the --a/--b/--c roots entirely.
+    if (!roots.empty()) {
+        if (roots.size() < MIN_ROOTS) {
+            std::cerr << "At least " << MIN_ROOTS << " roots are needed" << std::endl;
+            return false;
+        }
+        view = make_view(roots.data(), roots.size(), 0.0, view.left, view.top, view.iterations, view.precision);
+    }
+    view.unit = unit_width / static_cast<double>(options.width);
+    options.jobs.push_back(Job{ view, output });
+    return true;
+}
+
+#if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
+// Refuses what the bitstream cannot draw: engines other than the pipelined one, supersampling, recording goldens
+// and views without FPGA_ROOT_COUNT roots or with more iterations than its FPGA_NEWTON_DEPTH stages. Sweeps and
+// tiles are drawn one frame per batch.
+static bool fpga_options(Options& options) {
+    if (options.engine != Engine::Pipelined) {
+        std::cerr << "FPGA builds only hold the pipelined engine" << std::endl;
+        return false;
+    }
+    if (options.antialias != Antialias::Off) {
+        std::cerr << "FPGA builds draw one sample per pixel" << std::endl;
+        return false;
+    }
+    if (options.record) {
+        std::cerr << "Golden images are recorded by builds for other devices" << std::endl;
+        return false;
+    }
+    std::vector<View> views;
+    for (const Job& job : options.jobs) views.push_back(job.view);
+    for (const Keyframe& key : options.keyframes) views.push_back(key.view);
+    for (const View& view : views) {
+        if (view.root_count != FPGA_ROOT_COUNT) {
+            std::cerr << "FPGA builds draw " << FPGA_ROOT_COUNT << " roots only" << std::endl;
+            return false;
+        }
+        if (view.iterations > FPGA_NEWTON_DEPTH) {
+            std::cerr << "FPGA builds draw at most " << FPGA_NEWTON_DEPTH << " iterations" << std::endl;
+            return false;
+        }
+    }
+    options.batch = 1;
+    return true;
+}
+#endif
+
+static bool write_image(const std::string& path, uint32_t* pixels, const size_t w, const size_t h) {
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(
+        pixels, static_cast<int>(w), static_cast<int>(h), 32, static_cast<int>(w * sizeof(uint32_t)), SDL_PIXELFORMAT_ARGB8888
+    );
+    if (surface == NULL) {
+        std::cerr << "Cannot create surface: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    const bool ok = SDL_SaveBMP(surface, path.c_str()) == 0;
+    if (!ok) std::cerr << "Cannot write " << path << ": " << SDL_GetError() << std::endl;
+    SDL_FreeSurface(surface);
+    return ok;
+}
+
+// Copies a frame straight into the streaming texture's memory, saving SDL_UpdateTexture's copy out of a host
+// buffer. `frame` may be device or host memory; rows are re-pitched on the device when the texture pads them.
+static bool lock_upload(sycl::queue& q, SDL_Texture* texture, const uint32_t* frame, const size_t w, const size_t h) {
+    void* pixels;
+    int pitch;
+    if (SDL_LockTexture(texture, nullptr, &pixels, &pitch) != 0) return false;
+    const size_t row = w * sizeof(uint32_t);
+    if (static_cast<size_t>(pitch) == row) q.memcpy(pixels, frame, row * h).wait();
+    else q.ext_oneapi_memcpy2d(pixels, static_cast<size_t>(pitch), frame, row, row, h).wait();
+    SDL_UnlockTexture(texture);
+    return true;
+}
+
+// Renders every job without a window. Two contexts alternate so the device computes frame N + 1 while the
+// host is still encoding and writing frame N.
+static int run_headless(sycl::queue& q, const Options& options) {
+    RenderContext contexts[2] = { { q, options.width, options.height }, { q, options.width, options.height } };
+    std::future<bool> writer;
+    bool ok = true;
+    for (size_t i = 0; i < options.jobs.size(); ++i) {
+        const Job& job = options.jobs[i];
+        RenderContext& ctx = contexts[i % 2];
+        View view = job.view;
+        view.palette = options.palette;
+        view.antialias = options.antialias;
+        if (options.auto_precision) view.precision = precision_for_zoom(q.get_device(), view, ctx.width, ctx.height);
+        sycl::event done = submit_newton(ctx, options.engine, options.storage, view);
+        if (writer.valid()) ok = writer.get() && ok;
+        done.wait();
+        writer = std::async(std::launch::async, write_image, job.output, ctx.staging, ctx.width, ctx.height);
+        std::cout << job.output << std::endl;
+    }
+    if (writer.valid()) ok = writer.get() && ok;
+    return ok ? 0 : 1;
+}
+
+// View of `frame`, interpolated between the keyframes around it: roots and the view's centre linearly, the zoom
+// geometrically so that it changes at a constant rate.
+static View sweep_view(const std::vector<Keyframe>& keys, const size_t frame, const size_t w, const size_t h) {
+    size_t k = 0;
+    while (k + 1 < keys.size() && keys[k + 1].frame <= frame) ++k;
+    const View& a = keys[k].view;
+    if (k + 1 == keys.size()) return a;
+    const View& b = keys[k + 1].view;
+    const double t = static_cast<double>(frame - keys[k].frame) / static_cast<double>(keys[k + 1].frame - keys[k].frame);
+    View view = a;
+    for (size_t r = 0; r < a.root_count; ++r) view.roots[r] = a.roots[r] + (b.roots[r] - a.roots[r]) * static_cast<float>(t);
+    const double half_w = 0.5 * static_cast<double>(w), half_h = 0.5 * static_cast<double>(h);
+    const double ax = a.left + a.unit * half_w, ay = a.top - a.unit * half_h;
+    const double bx = b.left + b.unit * half_w, by = b.top - b.unit * half_h;
+    view.unit = a.unit * std::pow(b.unit / a.unit, t);
+    view.left = ax + (bx - ax) * t - view.unit * half_w;
+    view.top = ay + (by - ay) * t + view.unit * half_h;
+    const double iterations = static_cast<double>(a.iterations) + (static_cast<double>(b.iterations) - static_cast<double>(a.iterations)) * t;
+    view.iterations = static_cast<size_t>(std::llround(iterations));
+    return view;
+}
+
+// Packs a row of ARGB8888 pixels as 8-bit RGB.
+static void to_rgb(const uint32_t* pixels, const size_t w, char* rgb) {
+    for (size_t x = 0; x < w; ++x) {
+        rgb[3 * x] = static_cast<char>(pixels[x] >> 16);
+        rgb[3 * x + 1] = static_cast<char>(pixels[x] >> 8);
+        rgb[3 * x + 2] = static_cast<char>(pixels[x]);
+    }
+}
+
+// Appends `count` stacked w x h frames to a stream of binary PPM images, as read by ffmpeg -f image2pipe.
+static bool write_frames(std::ostream& out, const uint32_t* pixels, const size_t w, const size_t h, const size_t count) {
+    std::vector<char> row(w * 3);
+    for (size_t f = 0; f < count; ++f) {
+        out << "P6\n" << w << " " << h << "\n255\n";
+        for (size_t y = 0; y < h; ++y) {
+            to_rgb(pixels + (f * h + y) * w, w, row.data());
+            out.write(row.data(), static_cast<std::streamsize>(row.size()));
+        }
+    }
+    out.flush();
+    if (!out) std::cerr << "Cannot write sweep frames" << std::endl;
+    return static_cast<bool>(out);
+}
+
+// Renders every frame from keyframe 0 to the last one in batches of up to options.batch frames per launch. Two
+// contexts alternate so the device computes a batch while the host streams out the previous one. With auto
+// precision the deepest frame picks the batch's precision. "-" streams to standard output, with progress going to standard error.
+static int run_sweep(sycl::queue& q, const Options& options) {
+    const size_t w = options.width, h = options.height;
+    const std::vector<Keyframe>& keys = options.keyframes;
+    const size_t frames = keys.back().frame + 1;
+    const bool to_stdout = options.sweep_output == "-";
+    std::ofstream file;
+    if (to_stdout) {
+#if _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    }
+    else {
+        file.open(options.sweep_output, std::ios::binary);
+        if (!file) {
+            std::cerr << "Cannot open " << options.sweep_output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = to_stdout ? std::cout : file;
+    std::ostream& log = to_stdout ? std::cerr : std::cout;
+    RenderContext contexts[2] = { { q, w, h * options.batch }, { q, w, h * options.batch } };
+    std::vector<View> batch;
+    std::future<bool> writer;
+    bool ok = true;
+    for (size_t first = 0, b = 0; first < frames && ok; ++b) {
+        RenderContext& ctx = contexts[b % 2];
+        batch.clear();
+        for (size_t f = first; f < frames && batch.size() < options.batch; ++f) {
+            View view = sweep_view(keys, f, w, h);
+            view.palette = options.palette;
+            view.antialias = options.antialias;
+            batch.push_back(view);
+        }
+        if (options.auto_precision) {
+            const View& deepest = *std::min_element(batch.begin(), batch.end(), [](const View& x, const View& y) { return x.unit < y.unit; });
+            const Precision precision = precision_for_zoom(q.get_device(), deepest, w, h);
+            for (View& view : batch) view.precision = precision;
+        }
+        sycl::event done = submit_sweep(ctx, batch.data(), batch.size(), h);
+        if (writer.valid()) ok = writer.get() && ok;
+        done.wait();
+        writer = std::async(std::launch::async, write_frames, std::ref(out), ctx.staging, w, h, batch.size());
+        log << "Frames " << first << "-" << first + batch.size() - 1 << " of " << frames << std::endl;
+        first += batch.size();
+    }
+    if (writer.valid()) ok = writer.get() && ok;
+    return ok ? 0 : 1;
+}
+
+static uint32_t crc32(uint32_t crc, const char* data, const size_t size) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static uint32_t adler32(const uint32_t adler, const char* data, const size_t size) {
+    uint32_t a = adler & 0xFFFF, b = adler >> 16;
+    // 5552 bytes is the most that can be summed before b may overflow.
+    for (size_t i = 0; i < size; ) {
+        for (const size_t end = std::min<size_t>(size, i + 5552); i < end; ++i) {
+            a += static_cast<uint8_t>(data[i]);
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return b << 16 | a;
+}
+
+// Writes an image of known size row band by row band, as binary PPM or, for a .png path, as a PNG whose IDAT
+// chunks each hold one band in stored (uncompressed) deflate blocks. Only the current band is ever in memory.
+struct PosterWriter {
+    std::ofstream file;
+    std::ostream* out = &file;
+    std::string path;
+    size_t width = 0, height = 0, rows = 0;
+    bool png = false;
+    uint32_t adler = 1;
+    std::vector<char> data;
+
+    bool open(const std::string& p, const size_t w, const size_t h) {
+        path = p;
+        const bool is_png = p.size() > 4 && p.compare(p.size() - 4, 4, ".png") == 0;
+        if (is_png && (w > 0x7FFFFFFF || h > 0x7FFFFFFF)) {
+            std::cerr << "Image too large for PNG: " << w << "x" << h << std::endl;
+            return false;
+        }
+        file.open(p, std::ios::binary);
+        if (!file) {
+            std::cerr << "Cannot open " << p << std::endl;
+            return false;
+        }
+        return start(file, w, h, is_png);
+    }
+
+    // Starts the image on `stream`, which may be a std::ostringstream for images kept in memory.
+    bool start(std::ostream& stream, const size_t w, const size_t h, const bool as_png) {
+        out = &stream;
+        width = w;
+        height = h;
+        png = as_png;
+        if (!png) *out << "P6\n" << w << " " << h << "\n255\n";
+        else {
+            out->write("\x89PNG\r\n\x1a\n", 8);
+            data.clear();
+            put32(static_cast<uint32_t>(w));
+            put32(static_cast<uint32_t>(h));
+            // 8-bit RGB, deflate, adaptive filtering, no interlace.
+            data.insert(data.end(), { 8, 2, 0, 0, 0 });
+            chunk("IHDR");
+            // zlib header for a deflate stream with a 32K window and no preset dictionary.
+            data.insert(data.end(), { 0x78, 0x01 });
+        }
+        return check();
+    }
+
+    // Appends the first `count` rows of `pixels`; the last band also closes the file.
+    bool write(const uint32_t* pixels, const size_t count) {
+        if (!png) {
+            std::vector<char> row(width * 3);
+            for (size_t y = 0; y < count; ++y) {
+                to_rgb(pixels + y * width, width, row.data());
+                out->write(row.data(), static_cast<std::streamsize>(row.size()));
+            }
+        }
+        else {
+            // Each scanline is filter type 0 followed by its RGB bytes, split into stored blocks of at most 64K.
+            std::vector<char> raw(count * (1 + width * 3));
+            for (size_t y = 0; y < count; ++y) {
+                char* line = raw.data() + y * (1 + width * 3);
+                line[0] = 0;
+                to_rgb(pixels + y * width, width, line + 1);
+            }
+            const bool last = rows + count == height;
+            for (size_t offset = 0, size; offset < raw.size(); offset += size) {
+                size = std::min<size_t>(raw.size() - offset, 0xFFFF);
+                data.push_back(last && offset + size == raw.size() ? 1 : 0);
+                data.insert(data.end(), { static_cast<char>(size), static_cast<char>(size >> 8),
+                    static_cast<char>(~size), static_cast<char>(~size >> 8) });
+                data.insert(data.end(), raw.begin() + offset, raw.begin() + offset + size);
+            }
+            adler = adler32(adler, raw.data(), raw.size());
+            if (last) put32(adler);
+            chunk("IDAT");
+            if (last) chunk("IEND");
+        }
+        rows += count;
+        if (rows == height && out == &file) file.close();
+        return check();
+    }
+
+    void put32(const uint32_t v) {
+        data.insert(data.end(), { static_cast<char>(v >> 24), static_cast<char>(v >> 16), static_cast<char>(v >> 8), static_cast<char>(v) });
+    }
+
+    // Writes `data` as a chunk of `type` and empties it.
+    void chunk(const char* type) {
+        const uint32_t size = static_cast<uint32_t>(data.size());
+        const char header[8] = { static_cast<char>(size >> 24), static_cast<char>(size >> 16), static_cast<char>(size >> 8),
+            static_cast<char>(size), type[0], type[1], type[2], type[3] };
+        const uint32_t crc = crc32(crc32(0, type, 4), data.data(), data.size());
+        const char trailer[4] = { static_cast<char>(crc >> 24), static_cast<char>(crc >> 16), static_cast<char>(crc >> 8), static_cast<char>(crc) };
+        out->write(header, 8);
+        out->write(data.data(), static_cast<std::streamsize>(data.size()));
+        out->write(trailer, 4);
+        data.clear();
+    }
+
+    bool check() {
+        if (out->fail()) std::cerr << "Cannot write " << path << std::endl;
+        return !out->fail();
+    }
+};
+
+// Renders the job's view at options.width x options.height in bands of about POSTER_BAND_PIXELS, so device and
+// host memory stay bounded however large the image is. Two band contexts alternate so the device renders a band
+// while the host encodes and writes the previous one.
+static int run_poster(sycl::queue& q, const Options& options) {
+    const size_t w = options.width, h = options.height;
+    const size_t band = std::clamp<size_t>(POSTER_BAND_PIXELS / w, 1, h);
+    View view = options.jobs[0].view;
+    view.palette = options.palette;
+    view.antialias = options.antialias;
+    if (options.auto_precision) view.precision = precision_for_zoom(q.get_device(), view, w, h);
+    PosterWriter writer;
+    if (!writer.open(options.poster_output, w, h)) return 1;
+    RenderContext contexts[2] = { { q, w, band }, { q, w, band } };
+    std::future<bool> written;
+    bool ok = true;
+    for (size_t y = 0, i = 0; y < h && ok; y += band, ++i) {
+        RenderContext& ctx = contexts[i % 2];
+        View strip = view;
+        strip.top = view.top - view.unit * static_cast<double>(y);
+        sycl::event done = submit_newton(ctx, options.engine, options.storage, strip);
+        if (written.valid()) ok = written.get() && ok;
+        done.wait();
+        const size_t rows = std::min(band, h - y);
+        written = std::async(std::launch::async, [&writer, &ctx, rows] { return writer.write(ctx.staging, rows); });
+        std::cout << "Rows " << y << "-" << y + rows - 1 << " of " << h << std::endl;
+    }
+    if (written.valid()) ok = written.get() && ok;
+    return ok ? 0 : 1;
+}
+
+// PNG tiles by request key, in memory up to SERVE_CACHE_BYTES with the least recently used evicted first and, when
+// `directory` is set, also as files there that outlive the process. Safe to use from any thread.
+struct TileStore {
+    typedef std::shared_ptr<const std::string> Tile;
+    std::mutex mutex;
+    std::list<std::pair<std::string, Tile>> lru;
+    std::unordered_map<std::string, std::list<std::pair<std::string, Tile>>::iterator> index;
+    size_t bytes = 0;
+    std::string directory;
+
+    Tile find(const std::string& key) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto it = index.find(key);
+            if (it != index.end()) {
+                lru.splice(lru.begin(), lru, it->second);
+                return it->second->second;
+            }
+        }
+        if (directory.empty()) return nullptr;
+        std::ifstream in(file(key), std::ios::binary);
+        if (!in) return nullptr;
+        std::ostringstream data;
+        data << in.rdbuf();
+        const Tile tile = std::make_shared<const std::string>(data.str());
+        remember(key, tile);
+        return tile;
+    }
+
+    void insert(const std::string& key, const Tile& tile) {
+        remember(key, tile);
+        if (directory.empty()) return;
+        // Written under a temporary name first so that a concurrent reader never sees half a tile.
+        const std::string path = file(key), temporary = path + ".tmp";
+        std::ofstream out(temporary, std::ios::binary);
+        out.write(tile->data(), static_cast<std::streamsize>(tile->size()));
+        out.close();
+        if (out.fail() || std::rename(temporary.c_str(), path.c_str()) != 0) std::remove(temporary.c_str());
+    }
+
+    void remember(const std::string& key, const Tile& tile) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (index.count(key) != 0) return;
+        lru.emplace_front(key, tile);
+        index[key] = lru.begin();
+        bytes += tile->size();
+        while (bytes > SERVE_CACHE_BYTES && lru.size() > 1) {
+            bytes -= lru.back().second->size();
+            index.erase(lru.back().first);
+            lru.pop_back();
+        }
+    }
 
-#include <vector>
-#include <complex>
+    // File of a key, named by its 64-bit FNV-1a hash.
+    std::string file(const std::string& key) const {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (const char c : key) hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+        std::ostringstream name;
+        name << directory << "/" << std::hex << std::setw(16) << std::setfill('0') << hash << ".png";
+        return name.str();
+    }
+};
 
-using namespace std::literals::complex_literals;
-typedef std::complex<float> complex;
+// Renders the tiles requested by any number of connection threads on one device thread. Whatever queued up while
+// a batch was rendering goes into the next launch, up to `batch` tiles that share their root count, precision and
+// palette, and concurrent requests for the same tile wait for the same render.
+struct TileRenderer {
+    struct Pending {
+        View view;
+        std::promise<TileStore::Tile> promise;
+        std::shared_future<TileStore::Tile> future;
+    };
 
-constexpr size_t WIDTH = 1024, HEIGHT = 768;
-constexpr size_t ITERATION_COUNT = 20;
-constexpr uint8_t FILL_INTENSITY = 255;
+    RenderContext ctx;
+    TileStore& store;
+    const size_t batch;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::list<std::string> order;
+    std::unordered_map<std::string, Pending> pending;
 
-static auto exception_handler = [](sycl::exception_list e_list) {
-    for (std::exception_ptr const& e : e_list) {
+    TileRenderer(sycl::queue& q, TileStore& store, const size_t batch)
+        : ctx(q, SERVE_TILE, SERVE_TILE * batch), store(store), batch(batch) {}
+
+    std::shared_future<TileStore::Tile> request(const std::string& key, const View& view) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = pending.find(key);
+        if (it != pending.end()) return it->second.future;
+        Pending& p = pending[key];
+        p.view = view;
+        p.future = p.promise.get_future().share();
+        order.push_back(key);
+        ready.notify_one();
+        return p.future;
+    }
+
+    void run() {
+        for (;;) {
+            std::vector<std::string> keys;
+            std::vector<View> views;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this] { return !order.empty(); });
+                const View& first = pending[order.front()].view;
+                const size_t root_count = first.root_count;
+                const Precision precision = first.precision;
+                const Palette palette = first.palette;
+                for (auto it = order.begin(); it != order.end() && keys.size() < batch; ) {
+                    const View& view = pending[*it].view;
+                    if (view.root_count != root_count || view.precision != precision || view.palette != palette) {
+                        ++it;
+                        continue;
+                    }
+                    keys.push_back(*it);
+                    views.push_back(view);
+                    it = order.erase(it);
+                }
+            }
+            std::vector<TileStore::Tile> tiles;
+            std::exception_ptr failure;
+            try {
+                const auto start = std::chrono::steady_clock::now();
+                submit_sweep(ctx, views.data(), views.size(), SERVE_TILE).wait();
+                for (size_t f = 0; f < views.size(); ++f) {
+                    std::ostringstream png;
+                    PosterWriter writer;
+                    writer.start(png, SERVE_TILE, SERVE_TILE, true);
+                    writer.write(ctx.staging + f * SERVE_TILE * SERVE_TILE, SERVE_TILE);
+                    tiles.push_back(std::make_shared<const std::string>(png.str()));
+                    store.insert(keys[f], tiles.back());
+                }
+                const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                std::cout << "Rendered " << views.size() << " tiles in " << ms << " ms" << std::endl;
+            }
+            catch (...) {
+                failure = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t f = 0; f < keys.size(); ++f) {
+                Pending& p = pending[keys[f]];
+                if (failure) p.promise.set_exception(failure);
+                else p.promise.set_value(tiles[f]);
+                pending.erase(keys[f]);
+            }
+        }
+    }
+};
+
+static std::string url_decode(const std::string& text) {
+    std::string decoded;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '%' && i + 2 < text.size() && std::isxdigit(static_cast<uint8_t>(text[i + 1]))
+            && std::isxdigit(static_cast<uint8_t>(text[i + 2]))) {
+            decoded += static_cast<char>(std::stoi(text.substr(i + 1, 2), nullptr, 16));
+            i += 2;
+        }
+        else decoded += text[i] == '+' ? ' ' : text[i];
+    }
+    return decoded;
+}
+
+// Parses a tile path, /tile/z/x/y.png with optional root=re,im (repeated, MIN_ROOTS to MAX_ROOTS of them),
+// iterations, palette and precision query parameters. Tile 0/0/0 spans UNIT_WIDTH around the origin and every
+// level halves the span. On success `key` names the tile and everything that changes its pixels.
+static bool parse_tile(
+    const sycl::device& device, const std::string& target, View& view, std::string& key, std::string& error
+) {
+    const size_t query = target.find('?');
+    const std::string path = target.substr(0, query);
+    int z;
+    uint64_t x, y;
+    char s1, s2;
+    std::string suffix;
+    std::istringstream in(path);
+    if (path.compare(0, 6, "/tile/") != 0 || !(in.ignore(6) >> z >> s1 >> x >> s2 >> y >> suffix) || s1 != '/' || s2 != '/'
+        || suffix != ".png" || z < 0 || z > SERVE_MAX_ZOOM || x >> z != 0 || y >> z != 0) {
+        error = "expected /tile/z/x/y.png with 0 <= z <= " + std::to_string(SERVE_MAX_ZOOM) + " and x, y < 2^z";
+        return false;
+    }
+    const complex defaults[] = { -2.0f + 1.0if, 2.0f + 2.0if, -1.0f - 2.0if };
+    std::vector<complex> roots;
+    size_t iterations = ITERATION_COUNT;
+    Palette palette = Palette::Classic;
+    bool automatic = true;
+    Precision precision = Precision::Float;
+    std::istringstream parameters(query == std::string::npos ? "" : target.substr(query + 1));
+    for (std::string pair; std::getline(parameters, pair, '&'); ) {
+        const size_t equals = pair.find('=');
+        const std::string name = pair.substr(0, equals);
+        const std::string value = equals == std::string::npos ? "" : url_decode(pair.substr(equals + 1));
+        bool ok = true;
+        if (name == "root") {
+            complex root;
+            ok = parse_complex(value, root) && roots.size() < MAX_ROOTS;
+            roots.push_back(root);
+        }
+        else if (name == "iterations") ok = static_cast<bool>(std::istringstream(value) >> iterations) && iterations <= SERVE_MAX_ITERATIONS;
+        else if (name == "palette") ok = parse_palette(value, palette);
+        else if (name == "precision") {
+            automatic = value == "auto";
+            ok = automatic || parse_precision(value, precision);
+        }
+        else ok = name.empty();
+        if (!ok) {
+            error = "invalid parameter " + pair;
+            return false;
+        }
+    }
+    if (roots.empty()) roots.assign(defaults, defaults + 3);
+    if (roots.size() < MIN_ROOTS) {
+        error = "at least " + std::to_string(MIN_ROOTS) + " roots are needed";
+        return false;
+    }
+#if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
+    if (roots.size() != FPGA_ROOT_COUNT) {
+        error = "this FPGA build draws " + std::to_string(FPGA_ROOT_COUNT) + " roots only";
+        return false;
+    }
+    if (iterations > FPGA_NEWTON_DEPTH) {
+        error = "this FPGA build draws at most " + std::to_string(FPGA_NEWTON_DEPTH) + " iterations";
+        return false;
+    }
+#endif
+    const double span = std::ldexp(UNIT_WIDTH, -z);
+    view = make_view(roots.data(), roots.size(), span / SERVE_TILE, -UNIT_WIDTH / 2 + span * static_cast<double>(x),
+        UNIT_WIDTH / 2 - span * static_cast<double>(y), iterations, precision);
+    view.palette = palette;
+    view.precision = supported_precision(device, automatic ? precision_for_zoom(device, view, SERVE_TILE, SERVE_TILE) : precision);
+    std::ostringstream name;
+    name << z << "/" << x << "/" << y << " " << iterations << " " << palette_name(palette) << " " << precision_name(view.precision);
+    name.precision(9);
+    for (const complex& root : roots) name << " " << root.real() << "," << root.imag();
+    key = name.str();
+    return true;
+}
+
+static void send_all(const socket_t s, const std::string& data) {
+    for (size_t sent = 0; sent < data.size(); ) {
+        const int n = send(s, data.data() + sent, static_cast<int>(std::min<size_t>(data.size() - sent, 1 << 20)), 0);
+        if (n <= 0) return;
+        sent += static_cast<size_t>(n);
+    }
+}
+
+static void send_response(const socket_t s, const char* status, const char* type, const std::string& body) {
+    std::ostringstream header;
+    header << "HTTP/1.1 " << status << "\r\nContent-Type: " << type << "\r\nContent-Length: " << body.size()
+        << "\r\nAccess-Control-Allow-Origin: *\r\nConnection: close\r\n";
+    if (std::strcmp(status, "200 OK") == 0) header << "Cache-Control: public, max-age=86400\r\n";
+    header << "\r\n";
+    send_all(s, header.str());
+    send_all(s, body);
+}
+
+// Answers one HTTP request on `s` and closes it.
+static void serve_connection(const socket_t s, const sycl::device& device, TileStore& store, TileRenderer& renderer) {
+    std::string request;
+    char buffer[4096];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < SERVE_MAX_REQUEST) {
+        const int n = recv(s, buffer, static_cast<int>(sizeof(buffer)), 0);
+        if (n <= 0) break;
+        request.append(buffer, static_cast<size_t>(n));
+    }
+    std::istringstream line(request.substr(0, request.find("\r\n")));
+    std::string method, target, error, key;
+    View view{};
+    line >> method >> target;
+    if (method != "GET") send_response(s, "405 Method Not Allowed", "text/plain", "only GET is supported\n");
+    else if (!parse_tile(device, target, view, key, error)) send_response(s, "400 Bad Request", "text/plain", error + "\n");
+    else {
         try {
-            std::rethrow_exception(e);
+            TileStore::Tile tile = store.find(key);
+            if (!tile) tile = renderer.request(key, view).get();
+            send_response(s, "200 OK", "image/png", *tile);
         }
-        catch (std::exception const& e) {
-#if _DEBUG
-            std::cout << "Failure" << std::endl;
+        catch (const std::exception& e) {
+            send_response(s, "500 Internal Server Error", "text/plain", std::string(e.what()) + "\n");
+        }
+    }
+    closesocket(s);
+}
+
+// Serves SERVE_TILE-pixel PNG tiles over HTTP on options.serve_port until the process is stopped, answering
+// connections on SERVE_WORKERS threads; tiles missing from the store are rendered with the batched sweep kernel.
+static int run_serve(sycl::queue& q, const Options& options) {
+#if _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        std::cerr << "Cannot start Winsock" << std::endl;
+        return 1;
+    }
+#else
+    // A viewer that hangs up mid-tile must not kill the server.
+    std::signal(SIGPIPE, SIG_IGN);
 #endif
-            std::terminate();
+    const socket_t listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener == INVALID_SOCKET) {
+        std::cerr << "Cannot create socket" << std::endl;
+        return 1;
+    }
+    const int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(static_cast<uint16_t>(options.serve_port));
+    if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, SERVE_BACKLOG) != 0) {
+        std::cerr << "Cannot listen on port " << options.serve_port << std::endl;
+        closesocket(listener);
+        return 1;
+    }
+    TileStore store;
+    store.directory = options.tile_cache;
+    TileRenderer renderer(q, store, options.batch);
+    std::thread device_thread([&renderer] { renderer.run(); });
+    device_thread.detach();
+    const sycl::device device = q.get_device();
+    // A fixed pool of workers answers the accepted connections; beyond SERVE_MAX_QUEUED waiting ones, new
+    // connections are closed straight away so that a flood of clients cannot pile up threads or sockets.
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::list<socket_t> connections;
+    for (size_t i = 0; i < SERVE_WORKERS; ++i) {
+        std::thread([&] {
+            for (;;) {
+                socket_t s;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    ready.wait(lock, [&] { return !connections.empty(); });
+                    s = connections.front();
+                    connections.pop_front();
+                }
+                serve_connection(s, device, store, renderer);
+            }
+            }).detach();
+    }
+    std::cout << "Serving /tile/z/x/y.png on port " << options.serve_port << std::endl;
+    for (;;) {
+        const socket_t s = accept(listener, nullptr, nullptr);
+        if (s == INVALID_SOCKET) {
+            // Errors such as running out of descriptors persist for a while; retrying at once would spin.
+            std::cerr << "Cannot accept a connection (error " << socket_error() << ")" << std::endl;
+            std::this_thread::sleep_for(std::chrono::milliseconds(SERVE_ACCEPT_BACKOFF_MS));
+            continue;
+        }
+        // Idle or slow clients give up their worker after SERVE_TIMEOUT_MS.
+#if _WIN32
+        const DWORD timeout = SERVE_TIMEOUT_MS;
+#else
+        const timeval timeout{ SERVE_TIMEOUT_MS / 1000, SERVE_TIMEOUT_MS % 1000 * 1000 };
+#endif
+        setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+        setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+        std::lock_guard<std::mutex> lock(mutex);
+        if (connections.size() >= SERVE_MAX_QUEUED) {
+            closesocket(s);
+            continue;
         }
+        connections.push_back(s);
+        ready.notify_one();
     }
-    };
+}
 
-static void newton(
-    sycl::queue& q,
-    const complex a, const complex b, const complex c,
-    std::vector<complex>& buf, std::vector<uint8_t>& out,
-    const size_t w, const size_t h, const double unit,
-    const double left, const double top,
-    const size_t iterations
-) {
-    memset(out.data(), 0, out.size());
-    const complex sum = a + b + c;
-    const complex prod_sum = a * b + a * c + b * c;
-    const complex prod = a * b * c;
-    sycl::range<2> num_items{ h, w };
-    sycl::buffer<complex, 2> buf_vec{ buf.data(), num_items };
-    sycl::buffer<uint8_t, 1> buf_out(out.data(), sycl::range<1>(h * w * 4));
-    q.submit([&](sycl::handler& h) {
-        sycl::accessor vec(buf_vec, h, sycl::write_only);
-        h.parallel_for(num_items, [=](auto i) {
-            const double y = top - unit * i[0];
-            const double x = left + unit * i[1];
-            const complex v{ x, y };
-            vec[i] = v;
-            });
-        });
-    for (size_t i = 0; i < iterations; ++i) {
-        q.submit([&](sycl::handler& h) {
-            sycl::accessor vec(buf_vec, h, sycl::read_write);
-            h.parallel_for(num_items, [=](auto i) {
-                const complex x = vec[i];
-                const complex sqr = x * x;
-                const complex v = sqr * x - sum * sqr + prod_sum * x - prod;
-                const complex d = sqr * 3.0f - sum * x * 2.0f + prod_sum;
-                vec[i] = x - v / d;
-                });
-            });
+struct BenchmarkCase {
+    const char* name;
+    double left, top, unit_width;
+    size_t iterations;
+    size_t root_count;
+    complex roots[MAX_ROOTS];
+};
+
+// Fixed viewports, root configurations and iteration counts; keep names stable so results stay comparable.
+static const BenchmarkCase BENCHMARK_SUITE[] = {
+    { "overview", -5.0, 4.0, 10.0, 20, 3, { -2.0f + 1.0if, 2.0f + 2.0if, -1.0f - 2.0if } },
+    { "overview-200", -5.0, 4.0, 10.0, 200, 3, { -2.0f + 1.0if, 2.0f + 2.0if, -1.0f - 2.0if } },
+    { "boundary", 0.516502, 1.183171, 0.000002, 60, 3, { -2.0f + 1.0if, 2.0f + 2.0if, -1.0f - 2.0if } },
+    { "quintic", -5.0, 4.0, 10.0, 40, 5, { -2.0f + 1.0if, 2.0f + 2.0if, -1.0f - 2.0if, 1.0f - 1.0if, 3.0if } },
+    { "octic", -5.0, 4.0, 10.0, 40, 8, { 3.0f, 2.12f + 2.12if, 3.0if, -2.12f + 2.12if, -3.0f, -2.12f - 2.12if, -3.0if, 2.12f - 2.12if } },
+    // Sized for the FPGA bitstream: FPGA_ROOT_COUNT roots and FPGA_NEWTON_DEPTH iterations, around a basin edge.
+    { "edge-32", -0.5, 2.5, 2.0, 32, 3, { -2.0f + 1.0if, 2.0f + 2.0if, -1.0f - 2.0if } },
+};
+
+// Kernel and transfer time of one traced command, in milliseconds.
+static double device_ms(const sycl::event& event) {
+    const uint64_t start = event.get_profiling_info<sycl::info::event_profiling::command_start>();
+    const uint64_t end = event.get_profiling_info<sycl::info::event_profiling::command_end>();
+    return static_cast<double>(end - start) * 1e-6;
+}
+
+static std::string json_string(const std::string& text) {
+    std::string out = "\"";
+    for (const char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
     }
-    q.submit([&](sycl::handler& h) {
-        sycl::accessor vec(buf_vec, h, sycl::read_only);
-        sycl::accessor out(buf_out, h, sycl::write_only);
-        h.parallel_for(num_items, [=](auto i) {
-            const complex x = vec[i];
-            const complex da = x - a;
-            const complex db = x - b;
-            const complex dc = x - c;
-            const double da_hyp = da.real() * da.real() + da.imag() * da.imag();
-            const double db_hyp = db.real() * db.real() + db.imag() * db.imag();
-            const double dc_hyp = dc.real() * dc.real() + dc.imag() * dc.imag();
-            const size_t index = (i[0] * w + i[1]) * 4;
-            if (da_hyp <= db_hyp && da_hyp <= dc_hyp) out[index] = FILL_INTENSITY;
-            else if (db_hyp <= da_hyp && db_hyp <= dc_hyp) out[index + 1] = FILL_INTENSITY;
-            else out[index + 2] = FILL_INTENSITY;
-            });
-        });
-    q.wait();
+    return out + "\"";
 }
 
-#if FPGA_EMULATOR
-// Intel extension: FPGA emulator selector on systems without FPGA card.
-const auto device_selector = sycl::ext::intel::fpga_emulator_selector_v;
-#elif FPGA_SIMULATOR
-// Intel extension: FPGA simulator selector on systems without FPGA card.
-const auto device_selector = sycl::ext::intel::fpga_simulator_selector_v;
-#elif FPGA_HARDWARE
-// Intel extension: FPGA selector on systems with FPGA card.
-const auto device_selector = sycl::ext::intel::fpga_selector_v;
+// Renders every case of BENCHMARK_SUITE with each engine and precision tier, or only the ones given with
+// --engine and --precision, and writes the mean per-frame times as JSON. The queue must have enable_profiling.
+// Each configuration gets one untimed warm-up frame; the tile cache is dropped between frames so the tiled
+// engine is measured rendering rather than hitting its cache.
+static int run_benchmark(sycl::queue& q, const Options& options) {
+    std::ofstream file;
+    if (!options.benchmark_output.empty()) {
+        file.open(options.benchmark_output);
+        if (!file) {
+            std::cerr << "Cannot open " << options.benchmark_output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = options.benchmark_output.empty() ? std::cout : file;
+#if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
+    std::vector<Engine> engines = { Engine::Pipelined };
 #else
-// The default device selector will select the most performant device.
-const auto device_selector = sycl::default_selector_v;
+    // The pipelined engine is left out, as these builds draw it as the fused one.
+    std::vector<Engine> engines = { Engine::Fused, Engine::MultiPass, Engine::Tiled, Engine::Simd, Engine::Boundary };
+#endif
+    if (options.engine_given) engines = { options.engine };
+    std::vector<Precision> precisions;
+    for (const Precision p : { Precision::Half, Precision::Float, Precision::Double, Precision::DoubleFloat })
+        if ((options.auto_precision || p == options.jobs.front().view.precision) && precision_supported(q.get_device(), p))
+            precisions.push_back(p);
+    RenderContext ctx(q, options.width, options.height);
+    out << "{\n  \"device\": " << json_string(q.get_device().get_info<sycl::info::device::name>())
+        << ",\n  \"width\": " << ctx.width << ",\n  \"height\": " << ctx.height
+        << ",\n  \"frames\": " << BENCHMARK_FRAMES << ",\n  \"results\": [";
+    const char* separator = "\n";
+    for (const BenchmarkCase& c : BENCHMARK_SUITE) {
+#if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
+        // The bitstream is built for FPGA_ROOT_COUNT roots and FPGA_NEWTON_DEPTH iterations.
+        if (c.root_count != FPGA_ROOT_COUNT || c.iterations > FPGA_NEWTON_DEPTH) continue;
 #endif
+        for (const Engine engine : engines) {
+            for (const Precision precision : precisions) {
+                // These engines iterate in float whatever the view asks for.
+                if ((engine == Engine::MultiPass || engine == Engine::Simd || engine == Engine::Pipelined) && precision != Precision::Float) continue;
+                View view = make_view(
+                    c.roots, c.root_count, c.unit_width / static_cast<double>(ctx.width), c.left, c.top, c.iterations, precision
+                );
+                view.palette = options.palette;
+                view.antialias = options.antialias;
+                newton(ctx, engine, options.storage, view);
+                ctx.tiles.clear();
+                std::vector<std::pair<std::string, double>> commands;
+                double kernel_total = 0.0, transfer_total = 0.0;
+                ctx.tracing = true;
+                double wall = 0.0;
+                // Each frame is timed on its own so that emptying the tile cache, which keeps the tiled engine
+                // rendering every frame, is not counted.
+                for (size_t i = 0; i < BENCHMARK_FRAMES; ++i) {
+                    const auto start = std::chrono::steady_clock::now();
+                    newton(ctx, engine, options.storage, view);
+                    wall += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                    ctx.tiles.clear();
+                }
+                ctx.tracing = false;
+                for (const TraceEvent& e : ctx.trace) {
+                    const double ms = device_ms(e.event);
+                    (e.transfer ? transfer_total : kernel_total) += ms;
+                    auto k = std::find_if(commands.begin(), commands.end(), [&](const auto& p) { return p.first == e.name; });
+                    if (k == commands.end()) commands.emplace_back(e.name, ms);
+                    else k->second += ms;
+                }
+                ctx.trace.clear();
+                const double kernel_ms = kernel_total / BENCHMARK_FRAMES;
+                // Counts the iteration budget of every pixel, so early exits show up as higher throughput.
+                const double pixel_iterations = static_cast<double>(ctx.pixel_count()) * static_cast<double>(c.iterations);
+                out << separator << "    { \"case\": " << json_string(c.name) << ", \"engine\": " << json_string(engine_name(engine))
+                    << ", \"precision\": " << json_string(precision_name(precision)) << ", \"roots\": " << c.root_count
+                    << ", \"iterations\": " << c.iterations << ", \"wall_ms\": " << wall / BENCHMARK_FRAMES
+                    << ", \"kernel_ms\": " << kernel_ms << ", \"transfer_ms\": " << transfer_total / BENCHMARK_FRAMES
+                    << ", \"mpixel_iterations_per_s\": " << (kernel_ms > 0.0 ? pixel_iterations / (kernel_ms * 1e3) : 0.0)
+                    << ", \"commands\": {";
+                for (size_t k = 0; k < commands.size(); ++k)
+                    out << (k ? ", " : " ") << json_string(commands[k].first) << ": " << commands[k].second / BENCHMARK_FRAMES;
+                out << " } }";
+                separator = ",\n";
+                std::cerr << c.name << " " << engine_name(engine) << " " << precision_name(precision) << ": "
+                    << kernel_ms << " ms" << std::endl;
+            }
+        }
+    }
+    out << "\n  ]\n}" << std::endl;
+    return 0;
+}
 
-static double coords_to_pix_x(const double x, const double left, const double unit_width) {
-    return (x - left) / unit_width * static_cast<double>(WIDTH);
+// Share of pixels whose root must match the golden image; reduced precision may move basin edges by a pixel
+// here and there. Double-float rounds differently from fp64, and the deep boundary case amplifies that into
+// about 0.16% of its pixels picking another root, so it gets the float threshold for headroom.
+static double agreement_threshold(const Precision precision) {
+    switch (precision) {
+    case Precision::Half:
+        return 0.97;
+    case Precision::Float:
+    case Precision::DoubleFloat:
+        return 0.995;
+    case Precision::Double:
+        return 0.999;
+    }
+    return 1.0;
 }
 
-static double coords_to_pix_y(const double y, const double top, const double unit_height) {
-    return (top - y) / unit_height * static_cast<double>(HEIGHT);
+// Reads a binary 8-bit PPM (P6, three channels) or PGM (P5, one channel).
+static bool read_pnm(const std::string& path, const size_t channels, size_t& w, size_t& h, std::vector<char>& data) {
+    std::ifstream in(path, std::ios::binary);
+    std::string magic;
+    int max;
+    if (!(in >> magic >> w >> h >> max) || magic != (channels == 3 ? "P6" : "P5") || max != 255) return false;
+    in.get();
+    data.resize(w * h * channels);
+    return static_cast<bool>(in.read(data.data(), static_cast<std::streamsize>(data.size())));
 }
 
-static double pix_to_coords_x(const double x, const double left, const double unit_width) {
-    return x / static_cast<double>(WIDTH) * unit_width + left;
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+// Renders a golden image of `view` with the fused engine's sample loop into ctx.image, and into `mask` 255 for
+// every pixel whose sample converged and 0 for the others.
+template <size_t N, typename T>
+static void render_golden(RenderContext& ctx, const View& view, uint8_t* mask) {
+    const size_t w = ctx.width;
+    const Polynomial<N, T> poly = make_polynomial<N, T>(view);
+    const Grid<T> grid = make_grid<T>(view);
+    const PaletteLut lut = make_palette<T>(view);
+    const uint32_t iterations = static_cast<uint32_t>(view.iterations);
+    uint32_t* out = ctx.image;
+    ctx.q.parallel_for(sycl::range<2>{ ctx.height, w }, [=](auto i) {
+        const size_t index = i[0] * w + i[1];
+        uint32_t count;
+        bool converged;
+        out[index] = render_point(poly, lut, pixel_to_complex(grid, i[1], i[0]), iterations, count, converged);
+        mask[index] = converged ? 255 : 0;
+        });
 }
+#endif
 
-static double pix_to_coords_y(const double y, const double top, const double unit_height) {
-    return top - y / static_cast<double>(HEIGHT) * unit_height;
+// Renders every case of BENCHMARK_SUITE with each engine and precision tier, or the ones given with --engine and
+// --precision, in the index palette. Each result is compared pixel by pixel against the root index of the
+// case's golden image in options.verify, over the pixels its convergence mask (a PGM next to it) marks: the
+// nearest root of an iterate that ran out of iterations is arbitrary. A missing golden image or mask is an error;
+// with options.record both are first rendered by the fused engine in the most precise tier the device runs.
+// Frames are VERIFY_WIDTH x VERIFY_HEIGHT unless --size is given, and views are snapped to whole world pixels, as
+// the tiled engine always does; tiers a view is too deep for are skipped.
+//
+// The fused engine's other paths are checked too, in float or, for deep views, the reference tier: progressive
+// blocks, the shift of a pan, a warm-started root drag, a sweep batch and 2x2 and adaptive supersampling.
+// Supersampled runs are only scored away from basin edges, where their samples are meant to blend roots, and the
+// warm run further still, as its pixels keep the basins of roots primed VERIFY_DRAG_PIXELS away. Every
+// run reports its agreement and time, and the exit status is 1 if any fell below its threshold.
+static int run_verify(sycl::queue& q, const Options& options) {
+#if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
+    std::vector<Engine> engines = { Engine::Pipelined };
+#else
+    // The pipelined engine is left out, as these builds draw it as the fused one.
+    std::vector<Engine> engines = { Engine::Fused, Engine::MultiPass, Engine::Tiled, Engine::Simd, Engine::Boundary };
+#endif
+    if (options.engine_given) engines = { options.engine };
+    std::vector<Precision> precisions;
+    for (const Precision p : { Precision::Half, Precision::Float, Precision::Double, Precision::DoubleFloat })
+        if ((options.auto_precision || p == options.jobs.front().view.precision) && precision_supported(q.get_device(), p))
+            precisions.push_back(p);
+    const Precision reference = supported_precision(q.get_device(), Precision::Double);
+    const size_t width = options.size_given ? options.width : VERIFY_WIDTH;
+    const size_t height = options.size_given ? options.height : VERIFY_HEIGHT;
+    RenderContext ctx(q, width, height);
+    const size_t pixels = ctx.pixel_count();
+    size_t runs = 0, failures = 0;
+    std::vector<char> mask_host(pixels);
+    uint8_t* mask = nullptr;
+    if (options.record) {
+        mask = sycl::malloc_device<uint8_t>(pixels, q);
+        if (mask == nullptr) throw std::bad_alloc();
+    }
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+    // Sweeps are checked on the second frame of a two-frame batch.
+    RenderContext sweep_ctx(q, width, 2 * height);
+    const bool paths = !options.engine_given || options.engine == Engine::Fused;
+#endif
+    for (const BenchmarkCase& c : BENCHMARK_SUITE) {
+#if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
+        // The bitstream is built for FPGA_ROOT_COUNT roots and FPGA_NEWTON_DEPTH iterations.
+        if (c.root_count != FPGA_ROOT_COUNT || c.iterations > FPGA_NEWTON_DEPTH) continue;
+#endif
+        View view = make_view(c.roots, c.root_count, c.unit_width / static_cast<double>(width), c.left, c.top, c.iterations, reference);
+        view.palette = Palette::Index;
+        view.left = std::round(view.left / view.unit) * view.unit;
+        view.top = std::round(view.top / view.unit) * view.unit;
+        const std::string path = options.verify + "/" + c.name + ".ppm";
+        const std::string mask_path = options.verify + "/" + c.name + ".mask.pgm";
+        std::vector<char> golden, converged_mask;
+        size_t w, h;
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+        if (options.record) {
+            dispatch(view, [&](auto n, auto t) {
+                render_golden<decltype(n)::value, decltype(t)>(ctx, view, mask);
+                });
+            q.memcpy(ctx.staging, ctx.image, pixels * sizeof(uint32_t));
+            q.memcpy(mask_host.data(), mask, pixels).wait();
+            std::ofstream out(path, std::ios::binary);
+            std::ofstream mask_out(mask_path, std::ios::binary);
+            mask_out << "P5\n" << width << " " << height << "\n255\n";
+            mask_out.write(mask_host.data(), static_cast<std::streamsize>(pixels));
+            if (!write_frames(out, ctx.staging, width, height, 1) || !mask_out) {
+                std::cerr << "Cannot write " << path << " or " << mask_path << std::endl;
+                sycl::free(mask, q);
+                return 1;
+            }
+            std::cout << "Wrote golden image " << path << " and its convergence mask" << std::endl;
+        }
+#endif
+        if (!read_pnm(path, 3, w, h, golden) || !read_pnm(mask_path, 1, w, h, converged_mask)) {
+            std::cerr << "Missing or unreadable golden image " << path << " or mask " << mask_path
+                << "; run with --record to write them" << std::endl;
+            if (mask != nullptr) sycl::free(mask, q);
+            return 1;
+        }
+        if (w != width || h != height || golden.size() != 3 * pixels) {
+            std::cerr << path << " is not " << width << "x" << height << std::endl;
+            if (mask != nullptr) sycl::free(mask, q);
+            return 1;
+        }
+        const bool deep = precision_for_zoom(q.get_device(), view, width, height) != Precision::Float;
+        // Renders one run and scores the frame it returns, skipping pixels within `margin` pixels of another
+        // root in the golden image.
+        const auto check = [&](const std::string& name, const Precision precision, const double threshold, const size_t margin, auto&& render) {
+            const auto start = std::chrono::steady_clock::now();
+            const uint32_t* frame = render();
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            size_t agree = 0, scored = 0;
+            for (size_t y = 0; y < height; ++y) {
+                for (size_t x = 0; x < width; ++x) {
+                    const size_t i = y * width + x;
+                    if (converged_mask[i] == 0) continue;
+                    bool edge = false;
+                    for (size_t ny = y > margin ? y - margin : 0; margin > 0 && ny <= std::min(y + margin, height - 1); ++ny)
+                        for (size_t nx = x > margin ? x - margin : 0; nx <= std::min(x + margin, width - 1); ++nx)
+                            edge = edge || golden[3 * (ny * width + nx)] != golden[3 * i];
+                    if (edge) continue;
+                    ++scored;
+                    agree += static_cast<char>(frame[i] >> 16) == golden[3 * i];
+                }
+            }
+            const double agreement = scored == 0 ? 1.0 : static_cast<double>(agree) / static_cast<double>(scored);
+            const bool pass = agreement >= threshold;
+            ++runs;
+            failures += !pass;
+            std::cout << c.name << " " << name << " " << precision_name(precision) << ": "
+                << agreement * 100.0 << "% of roots agree (needs " << threshold * 100.0 << "%), " << ms << " ms"
+                << (pass ? "" : " FAILED") << std::endl;
+        };
+        for (const Engine engine : engines) {
+            for (const Precision precision : precisions) {
+                if ((engine == Engine::MultiPass || engine == Engine::Simd || engine == Engine::Pipelined) && precision != Precision::Float) continue;
+                if (deep && (precision == Precision::Half || precision == Precision::Float)) continue;
+                view.precision = precision;
+                check(engine_name(engine), precision, agreement_threshold(precision), 0, [&] {
+                    newton(ctx, engine, options.storage, view);
+                    ctx.tiles.release();
+                    return ctx.staging;
+                    });
+            }
+        }
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+        const Precision tier = deep ? reference : Precision::Float;
+        if (!paths || std::find(precisions.begin(), precisions.end(), tier) == precisions.end()) continue;
+        view.precision = tier;
+        const double threshold = agreement_threshold(tier);
+        // The same view panned by a few pixels, which the shift and the sweep batch start from.
+        View panned = view;
+        panned.left -= VERIFY_PAN_PIXELS * view.unit;
+        panned.top += VERIFY_PAN_PIXELS * view.unit;
+        check("progressive", tier, threshold, 0, [&] {
+            size_t block = PROGRESSIVE_BLOCK;
+            newton(ctx, Engine::Fused, options.storage, view, block);
+            while (block > 1) {
+                block /= 2;
+                newton(ctx, Engine::Fused, options.storage, view, block, true);
+            }
+            return ctx.staging;
+            });
+        check("shift", tier, threshold, 0, [&] {
+            ptrdiff_t dx, dy;
+            newton(ctx, Engine::Fused, options.storage, panned);
+            if (pan_offset(panned, view, dx, dy)) newton_shifted(ctx, view, dx, dy);
+            return ctx.staging;
+            });
+        check("sweep", tier, threshold, 0, [&] {
+            const View batch[] = { panned, view };
+            submit_sweep(sweep_ctx, batch, 2, height).wait();
+            return sweep_ctx.staging + pixels;
+            });
+        if (tier == Precision::Float) {
+            check("warm", tier, threshold, VERIFY_DRAG_PIXELS + 1, [&] {
+                View primed = view;
+                for (size_t k = 0; k < primed.root_count; ++k) primed.roots[k] += complex(0.0f, static_cast<float>(static_cast<double>(VERIFY_DRAG_PIXELS) * view.unit));
+                ctx.release_iterates();
+                newton_root_drag(ctx, primed);
+                newton_root_drag(ctx, view);
+                return ctx.staging;
+                });
+        }
+        for (const Antialias antialias : { Antialias::Grid2, Antialias::Adaptive }) {
+            View supersampled = view;
+            supersampled.antialias = antialias;
+            check(antialias_name(antialias), tier, threshold, 1, [&] {
+                newton(ctx, Engine::Fused, options.storage, supersampled);
+                return ctx.staging;
+                });
+        }
+#endif
+    }
+    if (mask != nullptr) sycl::free(mask, q);
+    std::cout << runs - failures << " of " << runs << " runs passed" << std::endl;
+    return failures == 0 ? 0 : 1;
 }
 
-static bool is_in_range(const double x1, const double y1, const double x2, const double y2) {
-    return std::abs(x1 - x2) < 5.0 && std::abs(y1 - y2) < 5.0;
+enum class Stage {
+    Kernels,
+    Transfers,
+    Upload,
+    Present,
+};
+
+static const char* stage_name(const Stage stage) {
+    switch (stage) {
+    case Stage::Kernels:
+        return "kernels";
+    case Stage::Transfers:
+        return "transfers";
+    case Stage::Upload:
+        return "upload";
+    case Stage::Present:
+        return "present";
+    }
+    return "unknown";
 }
 
+// Overlay colour of each stage, as RGB.
+constexpr uint32_t STAGE_COLORS[STAGE_COUNT] = { 0x00C0FF, 0xFFD000, 0xFF40FF, 0x808080 };
+
+// Collects per-stage times of every presented frame for the on-screen overlay and, when a trace file is open,
+// writes them as Chrome trace events for chrome://tracing or ui.perfetto.dev. Device commands are timed from
+// their profiling info and placed on the host timeline relative to the moment the frame started rendering.
+struct FrameProfiler {
+    bool overlay = false;
+    std::ofstream trace;
+    const char* separator = "\n";
+    uint64_t origin = SDL_GetPerformanceCounter();
+    double frame_start = 0.0;
+    std::array<double, STAGE_COUNT> current{};
+    std::vector<std::array<double, STAGE_COUNT>> history = std::vector<std::array<double, STAGE_COUNT>>(PROFILE_HISTORY);
+    size_t next = 0;
+
+    FrameProfiler() = default;
+    FrameProfiler(const FrameProfiler&) = delete;
+    FrameProfiler& operator=(const FrameProfiler&) = delete;
+
+    ~FrameProfiler() {
+        if (trace.is_open()) trace << "\n]" << std::endl;
+    }
+
+    bool open(const std::string& path) {
+        trace.open(path);
+        if (!trace) return false;
+        trace << "[";
+        write_thread_name(HOST_TID, "host");
+        write_thread_name(DEVICE_TID, "device");
+        return true;
+    }
+
+    bool active() const {
+        return overlay || trace.is_open();
+    }
+
+    // Microseconds since the profiler was created.
+    double now() const {
+        return static_cast<double>(SDL_GetPerformanceCounter() - origin) * 1e6 / static_cast<double>(SDL_GetPerformanceFrequency());
+    }
+
+    void begin_frame() {
+        frame_start = now();
+    }
+
+    // Accounts the host stage that started at `begin` (from now()) and ends now.
+    void host_stage(const Stage stage, const double begin) {
+        const double end = now();
+        current[static_cast<size_t>(stage)] += (end - begin) * 1e-3;
+        if (trace.is_open()) write_event(stage_name(stage), HOST_TID, begin, end - begin);
+    }
+
+    // Takes the commands ctx recorded this frame; the context must have been idle since.
+    void collect(RenderContext& ctx) {
+        if (ctx.trace.empty()) return;
+        const uint64_t base = ctx.trace.front().event.get_profiling_info<sycl::info::event_profiling::command_submit>();
+        for (const TraceEvent& e : ctx.trace) {
+            const uint64_t start = e.event.get_profiling_info<sycl::info::event_profiling::command_start>();
+            const uint64_t end = e.event.get_profiling_info<sycl::info::event_profiling::command_end>();
+            current[static_cast<size_t>(e.transfer ? Stage::Transfers : Stage::Kernels)] += (end - start) * 1e-6;
+            if (trace.is_open()) write_event(e.name, DEVICE_TID, frame_start + (start - base) * 1e-3, (end - start) * 1e-3);
+        }
+        ctx.trace.clear();
+    }
+
+    void end_frame() {
+        history[next] = current;
+        next = (next + 1) % PROFILE_HISTORY;
+        current = {};
+    }
+
+    double mean(const Stage stage) const {
+        double sum = 0.0;
+        for (const auto& frame : history) sum += frame[static_cast<size_t>(stage)];
+        return sum / PROFILE_HISTORY;
+    }
+
+    // One stacked bar per recent frame along the bottom-left corner, oldest first, with a line at the 60 Hz budget.
+    void draw(SDL_Renderer* renderer, const int height) const {
+        std::vector<SDL_FRect> bars[STAGE_COUNT];
+        for (size_t i = 0; i < PROFILE_HISTORY; ++i) {
+            const auto& frame = history[(next + i) % PROFILE_HISTORY];
+            float y = static_cast<float>(height - OVERLAY_MARGIN);
+            for (size_t s = 0; s < STAGE_COUNT; ++s) {
+                const float h = static_cast<float>(frame[s]) * OVERLAY_PIXELS_PER_MS;
+                y -= h;
+                bars[s].push_back(SDL_FRect{ static_cast<float>(OVERLAY_MARGIN + i * OVERLAY_BAR_WIDTH), y, OVERLAY_BAR_WIDTH, h });
+            }
+        }
+        for (size_t s = 0; s < STAGE_COUNT; ++s) {
+            SDL_SetRenderDrawColor(renderer, STAGE_COLORS[s] >> 16 & 0xFF, STAGE_COLORS[s] >> 8 & 0xFF, STAGE_COLORS[s] & 0xFF, 255);
+            SDL_RenderFillRectsF(renderer, bars[s].data(), static_cast<int>(bars[s].size()));
+        }
+        const int budget = height - OVERLAY_MARGIN - static_cast<int>(1000.0f / 60.0f * OVERLAY_PIXELS_PER_MS);
+        SDL_SetRenderDrawColor(renderer, FILL_INTENSITY, FILL_INTENSITY, FILL_INTENSITY, 255);
+        SDL_RenderDrawLine(renderer, OVERLAY_MARGIN, budget, OVERLAY_MARGIN + static_cast<int>(PROFILE_HISTORY * OVERLAY_BAR_WIDTH), budget);
+    }
+
+private:
+    static constexpr int HOST_TID = 1, DEVICE_TID = 2;
+
+    void write_event(const char* name, const int tid, const double ts, const double dur) {
+        trace << separator << "{ \"name\": " << json_string(name) << ", \"ph\": \"X\", \"pid\": 0, \"tid\": " << tid
+            << ", \"ts\": " << ts << ", \"dur\": " << dur << " }";
+        separator = ",\n";
+    }
+
+    void write_thread_name(const int tid, const char* name) {
+        trace << separator << "{ \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << tid
+            << ", \"args\": { \"name\": " << json_string(name) << " } }";
+        separator = ",\n";
+    }
+};
+
 int main(int argc, char* argv[]) {
     SDL_SetMainReady();
+    Options options;
+    if (!parse_options(argc, argv, options)) return 1;
+#if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
+    if (!fpga_options(options)) return 1;
+#endif
+    if (options.headless) {
+        // Only the benchmark pays for profiling timestamps.
+        const sycl::property_list properties = options.benchmark
+            ? sycl::property_list{ sycl::property::queue::in_order(), sycl::property::queue::enable_profiling() }
+            : sycl::property_list{ sycl::property::queue::in_order() };
+        sycl::queue queue(device_selector, exception_handler, properties);
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+        if (!options.engine_given && queue.get_device().is_cpu()) options.engine = Engine::Simd;
+#endif
+        if (options.serve_port != 0) return run_serve(queue, options);
+        if (!options.keyframes.empty()) return run_sweep(queue, options);
+        if (!options.poster_output.empty()) return run_poster(queue, options);
+        if (!options.verify.empty()) return run_verify(queue, options);
+        return options.benchmark ? run_benchmark(queue, options) : run_headless(queue, options);
+    }
     if (SDL_Init(SDL_INIT_VIDEO) != 0) {
         return 1;
     }
 
-    sycl::queue queue(device_selector, exception_handler);
-
-    constexpr size_t buffer_size = WIDTH * HEIGHT * 4;
-
-    std::vector<uint8_t> pixels(buffer_size);
-    std::vector<complex> buffer(buffer_size);
+    // Profiling is what the instrumentation overlay reads; it costs a pair of timestamps per command.
+    sycl::queue queue(
+        device_selector, exception_handler,
+        sycl::property_list{ sycl::property::queue::in_order(), sycl::property::queue::enable_profiling() }
+    );
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+    if (!options.engine_given && queue.get_device().is_cpu()) options.engine = Engine::Simd;
+#endif
+    RenderContext context(queue, WIDTH, HEIGHT);
+    FrameProfiler profiler;
+    int window_width = WIDTH, window_height = HEIGHT;
+    int output_width = WIDTH, output_height = HEIGHT;
+    double render_scale = 1.0;
+    size_t render_width = WIDTH, render_height = HEIGHT;
+    bool resized = true;
 
     bool running = true;
     bool changed = true;
     size_t frame_count = 0;
     uint32_t last_time = SDL_GetTicks();
     size_t iteration_count = ITERATION_COUNT;
-    complex a = -2.0f + 1.0if, b = 2.0f + 2.0if, c = -1.0f - 2.0if;
-    double unit_width = 10.0, left = -5.0, top = 4.0;
-    double unit_height = unit_width * (static_cast<double>(HEIGHT) / static_cast<double>(WIDTH));
-    SDL_FRect roots[3] = { {0.0, 0.0, 10.0, 10.0}, {0.0, 0.0, 10.0, 10.0}, {0.0, 0.0, 10.0, 10.0} };
+    Engine engine = options.engine;
+    IterateStorage storage = IterateStorage::Float;
+    bool progressive = true;
+    size_t progressive_block = PROGRESSIVE_BLOCK;
+    size_t block = 1;
+    uint32_t pass_budget = PASS_BUDGET_MS;
+    IterationGovernor governor;
+    RenderScheduler scheduler;
+    bool governed = true;
+    const bool count_work = queue.get_device().has(sycl::aspect::atomic64);
+    std::unique_ptr<MultiDeviceRenderer> devices;
+    std::unique_ptr<FramePipeline> pipeline;
+    size_t pipeline_depth = 0;
+    const uint32_t* frame = nullptr;
+    bool lock_texture = true;
+    View shown{};
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+    bool warm_drag = true;
+    bool shown_complete = false;
+#endif
+    bool shown_warm = false;
+    uint32_t shown_warm_ticks = 0;
+    const complex default_roots[] = { -2.0f + 1.0if, 2.0f + 2.0if, -1.0f - 2.0if };
+    complex roots[MAX_ROOTS];
+    size_t root_count = 3;
+    std::copy(default_roots, default_roots + root_count, roots);
+    bool auto_precision = options.auto_precision;
+    Precision precision = Precision::Float;
+    Palette palette = options.palette;
+    Antialias antialias = options.antialias;
+    int zoom_level = 0;
+    double unit_width = zoom_width(zoom_level), left = -5.0, top = 4.0;
+    double aspect = static_cast<double>(HEIGHT) / static_cast<double>(WIDTH);
+    double unit_height = unit_width * aspect;
+    SDL_FRect markers[MAX_ROOTS];
+    std::fill(markers, markers + MAX_ROOTS, SDL_FRect{ 0.0, 0.0, 10.0, 10.0 });
     size_t point_dragging_index = 0;
     bool position_dragging = false;
 
@@ -166,46 +3727,38 @@ int main(int argc, char* argv[]) {
     );
     if (renderer == NULL) goto end;
 
-    texture = SDL_CreateTexture(
-        renderer,
-        SDL_PIXELFORMAT_ARGB8888,
-        SDL_TEXTUREACCESS_STREAMING,
-        WIDTH,
-        HEIGHT
-    );
-    if (texture == NULL) goto end;
+    if (!options.trace.empty()) {
+        if (!profiler.open(options.trace)) {
+            std::cerr << "Cannot open trace file " << options.trace << std::endl;
+            goto end;
+        }
+        context.tracing = true;
+    }
 
     while (running) {
-        while (SDL_PollEvent(&event)) {
+        while (scheduler.next_event(event)) {
             switch (event.type) {
             case SDL_QUIT:
                 running = false;
                 break;
-            case SDL_WINDOWEVENT_RESIZED:
-                changed = true;
+            case SDL_WINDOWEVENT:
+                // SIZE_CHANGED also covers programmatic and HiDPI drawable changes, unlike RESIZED.
+                if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) resized = true;
                 break;
             case SDL_MOUSEBUTTONUP:
                 if (event.button.button == SDL_BUTTON_LEFT) {
                     point_dragging_index = 0;
-                    std::cout << "a: " << a << std::endl;
-                    std::cout << "b: " << b << std::endl;
-                    std::cout << "c: " << c << std::endl;
+                    for (size_t i = 0; i < root_count; ++i) std::cout << "root " << i << ": " << roots[i] << std::endl;
                 }
                 else if (event.button.button == SDL_BUTTON_RIGHT) position_dragging = false;
                 break;
             case SDL_MOUSEBUTTONDOWN:
                 if (event.button.button == SDL_BUTTON_LEFT) {
-                    if (is_in_range(roots[0].x + 5.0, roots[0].y + 5.0, event.button.x, event.button.y)) {
-                        changed = true;
-                        point_dragging_index = 1;
-                    }
-                    else if (is_in_range(roots[1].x + 5.0, roots[1].y + 5.0, event.button.x, event.button.y)) {
-                        changed = true;
-                        point_dragging_index = 2;
-                    }
-                    else if (is_in_range(roots[2].x + 5.0, roots[2].y + 5.0, event.button.x, event.button.y)) {
+                    for (size_t i = 0; i < root_count; ++i) {
+                        if (!is_in_range(markers[i].x + 5.0, markers[i].y + 5.0, event.button.x, event.button.y)) continue;
                         changed = true;
-                        point_dragging_index = 3;
+                        point_dragging_index = i + 1;
+                        break;
                     }
                 }
                 else if (event.button.button == SDL_BUTTON_RIGHT) {
@@ -214,24 +3767,14 @@ int main(int argc, char* argv[]) {
                 break;
             case SDL_MOUSEMOTION:
                 if (point_dragging_index) {
-                    const double x = pix_to_coords_x(event.motion.x, left, unit_width);
-                    const double y = pix_to_coords_y(event.motion.y, top, unit_height);
+                    const double x = pix_to_coords_x(event.motion.x, left, unit_width, window_width);
+                    const double y = pix_to_coords_y(event.motion.y, top, unit_height, window_height);
                     changed = true;
-                    switch (point_dragging_index) {
-                    case 1:
-                        a = complex(x, y);
-                        break;
-                    case 2:
-                        b = complex(x, y);
-                        break;
-                    case 3:
-                        c = complex(x, y);
-                        break;
-                    }
+                    roots[point_dragging_index - 1] = complex(static_cast<float>(x), static_cast<float>(y));
                 }
                 else if (position_dragging) {
-                    left -= event.motion.xrel * unit_width / static_cast<double>(WIDTH);
-                    top += event.motion.yrel * unit_height / static_cast<double>(HEIGHT);
+                    left -= event.motion.xrel * unit_width / window_width;
+                    top += event.motion.yrel * unit_height / window_height;
                     changed = true;
                 }
                 break;
@@ -240,21 +3783,145 @@ int main(int argc, char* argv[]) {
                 changed = true;
                 top -= unit_height * event.wheel.y * 0.025;
                 left += unit_width * event.wheel.y * 0.025;
-                unit_width *= std::pow(0.95, event.wheel.y);
-                unit_height = unit_width * (static_cast<double>(HEIGHT) / static_cast<double>(WIDTH));
+                zoom_level += event.wheel.y;
+                unit_width = zoom_width(zoom_level);
+                unit_height = unit_width * aspect;
                 break;
             case SDL_KEYDOWN:
                 if (event.key.keysym.sym == SDLK_r) {
-                    a = -2.0 + 1.0i, b = 2.0 + 2.0i, c = -1.0 - 2.0i;
-                    unit_width = 10.0, left = -5.0, top = 4.0;
-                    unit_height = unit_width * (static_cast<double>(HEIGHT) / static_cast<double>(WIDTH));
+                    root_count = 3;
+                    std::copy(default_roots, default_roots + root_count, roots);
+                    zoom_level = 0;
+                    unit_width = zoom_width(zoom_level), left = -5.0, top = 4.0;
+                    unit_height = unit_width * aspect;
                     point_dragging_index = 0;
                     position_dragging = false;
                     iteration_count = 20;
                     changed = true;
                     std::cout << "Reset" << std::endl;
                 }
-                else if (event.key.keysym.sym == SDLK_UP) {
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+                // FPGA builds have a single engine, root count and sample per pixel, and keep no iterates.
+                else if (event.key.keysym.sym == SDLK_e) {
+                    engine = static_cast<Engine>((static_cast<int>(engine) + 1) % 6);
+                    if (engine == Engine::Fused) context.release_iterates();
+                    // Rebuilds the pipeline, which the boundary engine goes without.
+                    if (pipeline_depth > 0) resized = true;
+                    changed = true;
+                    std::cout << "Engine: " << engine_name(engine) << std::endl;
+                }
+                else if (event.key.keysym.sym == SDLK_i) {
+                    storage = static_cast<IterateStorage>((static_cast<int>(storage) + 1) % 3);
+                    if (engine == Engine::MultiPass) changed = true;
+                    if (pipeline) resized = true;
+                    std::cout << "Iterate storage: " << iterate_storage_name(storage) << std::endl;
+                }
+                else if (event.key.keysym.sym == SDLK_EQUALS && root_count < MAX_ROOTS) {
+                    int mouse_x, mouse_y;
+                    SDL_GetMouseState(&mouse_x, &mouse_y);
+                    roots[root_count++] = complex(
+                        static_cast<float>(pix_to_coords_x(mouse_x, left, unit_width, window_width)),
+                        static_cast<float>(pix_to_coords_y(mouse_y, top, unit_height, window_height))
+                    );
+                    changed = true;
+                    std::cout << "Roots: " << root_count << std::endl;
+                }
+                else if (event.key.keysym.sym == SDLK_MINUS && root_count > MIN_ROOTS) {
+                    --root_count;
+                    point_dragging_index = 0;
+                    changed = true;
+                    std::cout << "Roots: " << root_count << std::endl;
+                }
+#endif
+                else if (event.key.keysym.sym == SDLK_x) {
+                    // Cycles auto, then every tier the device supports, then back to auto.
+                    if (auto_precision) {
+                        auto_precision = false;
+                        precision = Precision::Half;
+                    }
+                    else if (precision == Precision::DoubleFloat) auto_precision = true;
+                    else precision = static_cast<Precision>(static_cast<int>(precision) + 1);
+                    while (!auto_precision && !precision_supported(queue.get_device(), precision))
+                        precision = static_cast<Precision>(static_cast<int>(precision) + 1);
+                    changed = true;
+                    std::cout << "Precision: " << (auto_precision ? "auto" : precision_name(precision)) << std::endl;
+                }
+                else if (event.key.keysym.sym == SDLK_c) {
+                    // The index palette is left out; it is only meant for --verify and image diffs.
+                    palette = static_cast<Palette>((static_cast<int>(palette) + 1) % static_cast<int>(Palette::Index));
+                    changed = true;
+                    std::cout << "Palette: " << palette_name(palette) << std::endl;
+                }
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+                else if (event.key.keysym.sym == SDLK_n) {
+                    antialias = static_cast<Antialias>((static_cast<int>(antialias) + 1) % 5);
+                    changed = true;
+                    std::cout << "Antialiasing: " << antialias_name(antialias) << std::endl;
+                }
+#endif
+                else if (event.key.keysym.sym == SDLK_o) {
+                    profiler.overlay = !profiler.overlay;
+                    context.tracing = profiler.active();
+                    context.trace.clear();
+                    std::cout << "Overlay: " << (profiler.overlay ? "on" : "off") << std::endl;
+                    if (profiler.overlay) {
+                        std::cout << "  kernels cyan, transfers yellow, upload magenta, present grey; the line is 1/60 s" << std::endl;
+                    }
+                }
+                else if (event.key.keysym.sym == SDLK_u) {
+                    lock_texture = !lock_texture;
+                    changed = true;
+                    std::cout << "Texture upload: " << (lock_texture ? "lock" : "update") << std::endl;
+                }
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+                else if (event.key.keysym.sym == SDLK_k) {
+                    warm_drag = !warm_drag;
+                    std::cout << "Warm-started root drag: " << (warm_drag ? "on" : "off") << std::endl;
+                }
+#endif
+                else if (event.key.keysym.sym == SDLK_g) {
+                    governed = !governed;
+                    governor = IterationGovernor();
+                    std::cout << "Iteration governor: " << (governed ? "on" : "off") << std::endl;
+                }
+                else if (event.key.keysym.sym == SDLK_p) {
+                    progressive = !progressive;
+                    changed = true;
+                    std::cout << "Progressive: " << (progressive ? "on" : "off") << std::endl;
+                }
+                else if (event.key.keysym.sym == SDLK_LEFTBRACKET || event.key.keysym.sym == SDLK_RIGHTBRACKET) {
+                    if (event.key.keysym.sym == SDLK_RIGHTBRACKET) pass_budget += 4;
+                    else if (pass_budget > 4) pass_budget -= 4;
+                    std::cout << "Pass budget: " << pass_budget << " ms" << std::endl;
+                }
+                else if (event.key.keysym.sym == SDLK_l) {
+                    context.tiles.local_size = (context.tiles.local_size + 1) % TILE_LOCAL_SIZE_COUNT;
+                    if (engine == Engine::Tiled) changed = true;
+                    std::cout << "Tile work-group: " << TILE_LOCAL_SIZES[context.tiles.local_size][0] << "x"
+                        << TILE_LOCAL_SIZES[context.tiles.local_size][1] << std::endl;
+                }
+                else if (event.key.keysym.sym == SDLK_m) {
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+                    if (devices) devices.reset();
+                    else devices = std::make_unique<MultiDeviceRenderer>(queue.get_device(), render_width, render_height);
+                    changed = true;
+                    std::cout << "Devices: " << (devices ? devices->shares.size() : 1) << std::endl;
+                    for (size_t i = 0; devices && i < devices->shares.size(); ++i)
+                        std::cout << "  " << devices->shares[i]->q.get_device().get_info<sycl::info::device::name>() << std::endl;
+#endif
+                }
+                else if (event.key.keysym.sym == SDLK_PAGEUP || event.key.keysym.sym == SDLK_PAGEDOWN) {
+                    const double step = event.key.keysym.sym == SDLK_PAGEUP ? 0.25 : -0.25;
+                    render_scale = std::min(2.0, std::max(0.25, render_scale + step));
+                    resized = true;
+                    std::cout << "Render scale: " << render_scale << std::endl;
+                }
+                else if (event.key.keysym.sym == SDLK_f) {
+                    pipeline_depth = pipeline_depth == 0 ? 2 : pipeline_depth == 2 ? 3 : 0;
+                    resized = true;
+                    std::cout << "Frames in flight: " << (pipeline_depth == 0 ? 1 : pipeline_depth) << std::endl;
+                }
+                else if (event.key.keysym.sym == SDLK_UP && iteration_count < MAX_ITERATION_COUNT) {
                     ++iteration_count;
                     changed = true;
                     std::cout << "Iterations: " << iteration_count << std::endl;
@@ -268,61 +3935,208 @@ int main(int argc, char* argv[]) {
                 break;
             }
         }
+        // Everything held since the previous frame is folded into one move, scaled by the time that passed.
+        scheduler.begin_frame();
         const uint8_t* keyboard = SDL_GetKeyboardState(NULL);
-        if (keyboard[SDL_SCANCODE_A] && keyboard[SDL_SCANCODE_D]) {}
-        else if (keyboard[SDL_SCANCODE_A]) {
+        const bool shift = keyboard[SDL_SCANCODE_LSHIFT] || keyboard[SDL_SCANCODE_RSHIFT];
+        // Keyboard pans move by whole pixels so the previous frame can be shifted instead of re-rendered.
+        const double pixel = unit_width / static_cast<double>(render_width);
+        if (const int n = scheduler.steps(0, keyboard[SDL_SCANCODE_D] - keyboard[SDL_SCANCODE_A], PAN_PIXELS_PER_SECOND)) {
             changed = true;
-            left -= unit_width * 0.01;
+            left += n * pixel;
         }
-        else if (keyboard[SDL_SCANCODE_D]) {
+        if (const int n = scheduler.steps(1, keyboard[SDL_SCANCODE_W] - keyboard[SDL_SCANCODE_S], PAN_PIXELS_PER_SECOND)) {
             changed = true;
-            left += unit_width * 0.01;
+            top += n * pixel;
         }
-        if (keyboard[SDL_SCANCODE_W] && keyboard[SDL_SCANCODE_S]) {}
-        else if (keyboard[SDL_SCANCODE_S]) {
+        for (int n = scheduler.steps(2, shift - keyboard[SDL_SCANCODE_SPACE], ZOOM_LEVELS_PER_SECOND); n != 0; n -= n > 0 ? 1 : -1) {
             changed = true;
-            top -= unit_width * 0.01;
+            const double in = n > 0 ? 1.0 : -1.0;
+            top -= in * unit_height * 0.025;
+            left += in * unit_width * 0.025;
+            zoom_level += n > 0 ? 1 : -1;
+            unit_width = zoom_width(zoom_level);
+            unit_height = unit_width * aspect;
         }
-        else if (keyboard[SDL_SCANCODE_W]) {
+        if (resized) {
+            // Mouse events arrive in window coordinates while the drawable may be larger on HiDPI screens; drawing
+            // is scaled to window coordinates and the fractal renders at the drawable size times render_scale.
+            SDL_GetWindowSize(window, &window_width, &window_height);
+            SDL_GetRendererOutputSize(renderer, &output_width, &output_height);
+            SDL_RenderSetScale(
+                renderer,
+                static_cast<float>(output_width) / static_cast<float>(window_width),
+                static_cast<float>(output_height) / static_cast<float>(window_height)
+            );
+            render_width = scaled_size(output_width, render_scale);
+            render_height = scaled_size(output_height, render_scale);
+            context.resize(render_width, render_height);
+            if (devices) devices = std::make_unique<MultiDeviceRenderer>(queue.get_device(), render_width, render_height);
+            pipeline.reset();
+            // The boundary engine reads its tile count back at every subdivision level, which would stall the
+            // pipeline on each frame, so it renders one frame at a time.
+            if (pipeline_depth > 0 && engine != Engine::Boundary)
+                pipeline = std::make_unique<FramePipeline>(queue, pipeline_depth, render_width, render_height, storage);
+            if (texture != NULL) SDL_DestroyTexture(texture);
+            texture = SDL_CreateTexture(
+                renderer,
+                SDL_PIXELFORMAT_ARGB8888,
+                SDL_TEXTUREACCESS_STREAMING,
+                static_cast<int>(render_width),
+                static_cast<int>(render_height)
+            );
+            if (texture == NULL) goto end;
+            aspect = static_cast<double>(render_height) / static_cast<double>(render_width);
+            unit_height = unit_width * aspect;
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+            shown_complete = false;
+#endif
+            resized = false;
             changed = true;
-            top += unit_width * 0.01;
         }
-        if ((keyboard[SDL_SCANCODE_LSHIFT] || keyboard[SDL_SCANCODE_RSHIFT]) && keyboard[SDL_SCANCODE_SPACE]) {}
-        else if (keyboard[SDL_SCANCODE_LSHIFT] || keyboard[SDL_SCANCODE_RSHIFT]) {
-            changed = true;
-            top -= unit_height * 0.025;
-            left += unit_width * 0.025;
-            unit_width *= 0.95;
-            unit_height = unit_width * (static_cast<double>(HEIGHT) / static_cast<double>(WIDTH));
+        View view = make_view(
+            roots, root_count, unit_width / static_cast<double>(render_width), left, top, iteration_count, precision
+        );
+        view.palette = palette;
+        view.antialias = antialias;
+        if (auto_precision) {
+            view.precision = precision_for_zoom(queue.get_device(), view, render_width, render_height);
+            if (view.precision != precision) std::cout << "Precision: " << precision_name(view.precision) << " (auto)" << std::endl;
+            precision = view.precision;
         }
-        else if (keyboard[SDL_SCANCODE_SPACE]) {
-            changed = true;
-            top += unit_height * 0.025;
-            left -= unit_width * 0.025;
-            unit_width *= 1.05;
-            unit_height = unit_width * (static_cast<double>(HEIGHT) / static_cast<double>(WIDTH));
-        }
-        if (changed) {
-            newton(queue, a, b, c, buffer, pixels, WIDTH, HEIGHT, unit_width / static_cast<double>(WIDTH), left, top, iteration_count);
-            SDL_UpdateTexture(texture, nullptr, pixels.data(), WIDTH * 4);
+        View rendered = view;
+        bool redraw = false;
+        bool warm = false;
+        // A warm-started preview is replaced once the drag ends or the root has rested for WARM_IDLE_MS.
+        const bool warm_stale = shown_warm && (!point_dragging_index || SDL_GetTicks() - shown_warm_ticks >= WARM_IDLE_MS);
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+        ptrdiff_t dx = 0, dy = 0;
+#endif
+        frame = nullptr;
+        context.stage_output = !lock_texture;
+        if (profiler.active()) profiler.begin_frame();
+        if (pipeline) {
+            // Input that arrives while every slot is busy is coalesced into the next submitted view.
+            if (changed && pipeline->submit(engine, storage, view)) changed = false;
+            if (const FramePipeline::Slot* slot = pipeline->poll()) {
+                frame = slot->ctx.staging;
+                shown = slot->view;
+                redraw = true;
+            }
+            block = 1;
+        }
+        else if (changed && devices) {
+            devices->render(context.staging, engine, storage, view);
+            frame = context.staging;
+            block = 1;
+            changed = false;
+            redraw = true;
+        }
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+        else if (changed && warm_drag && point_dragging_index && antialias == Antialias::Off
+            && (view.precision == Precision::Half || view.precision == Precision::Float)) {
+            // Dragging a root only re-converges the previous frame's iterates, whatever the engine.
+            newton_root_drag(context, view);
+            block = 1;
+            changed = false;
+            redraw = true;
+            warm = true;
+        }
+        else if (changed && engine == Engine::Fused && shown_complete && pan_offset(shown, view, dx, dy)
+            && std::abs(dx) < static_cast<ptrdiff_t>(render_width) && std::abs(dy) < static_cast<ptrdiff_t>(render_height)) {
+            newton_shifted(context, view, dx, dy);
+            block = 1;
+            changed = false;
+            redraw = true;
+        }
+#endif
+        else if (changed) {
+            // While input keeps arriving only a coarse pass is drawn, with the governed iteration budget; it
+            // gets coarser if it overruns the pass budget.
+            block = progressive && engine == Engine::Fused && antialias == Antialias::Off ? progressive_block : 1;
+            rendered.iterations = governed ? governor.budget(iteration_count) : iteration_count;
+            context.count_work = governed && count_work && engine == Engine::Fused;
+            const auto start = std::chrono::steady_clock::now();
+            newton(context, engine, storage, rendered, block);
+            const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            context.count_work = false;
+            if (block > 1 && elapsed > pass_budget) progressive_block = PROGRESSIVE_MAX_BLOCK;
+            else if (block > 1 && elapsed < pass_budget / 4.0) progressive_block = PROGRESSIVE_BLOCK;
+            if (governed && engine == Engine::Fused && count_work) {
+                governor.update(pass_budget, elapsed, rendered.iterations, iteration_count, context.work_host[0], context.work_host[1]);
+            }
+            // Without counts every sample is assumed to use the whole budget.
+            else if (governed) governor.update(pass_budget, elapsed, rendered.iterations, iteration_count, rendered.iterations, 1);
+            changed = false;
+            redraw = true;
+        }
+        else if (block > 1 || warm_stale || (!pipeline && !devices && shown.iterations != view.iterations)) {
+            // Idle: restore full quality. A pass taken with a governed budget cannot be refined, and a warm-started
+            // one may have kept pixels in basins they have left, so both are redone. Refinement stops as soon as
+            // input is queued, as its view is stale by then.
+            const uint32_t start = SDL_GetTicks();
+            if (warm_stale || shown.iterations != view.iterations) newton(context, engine, storage, view, block);
+            while (block > 1 && SDL_GetTicks() - start < pass_budget && !RenderScheduler::input_pending()) {
+                block /= 2;
+                newton(context, engine, storage, view, block, true);
+            }
+            redraw = true;
+        }
+        if (profiler.active()) profiler.collect(context);
+        if (redraw) {
+            if (!pipeline) shown = rendered;
+#if !(FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR)
+            shown_complete = block == 1 && !devices && !pipeline && !warm;
+#endif
+            if (warm) shown_warm_ticks = SDL_GetTicks();
+            shown_warm = warm;
+            if (frame == nullptr) frame = context.stage_output ? context.staging : context.image;
+            const double upload_start = profiler.now();
+            if (lock_texture && !lock_upload(queue, texture, frame, render_width, render_height)) {
+                std::cerr << "Cannot lock texture: " << SDL_GetError() << std::endl;
+                lock_texture = false;
+                changed = true;
+            }
+            else if (!lock_texture) SDL_UpdateTexture(texture, nullptr, frame, static_cast<int>(render_width * sizeof(uint32_t)));
+            if (profiler.active()) profiler.host_stage(Stage::Upload, upload_start);
+        }
+        // The overlay changes every frame, so the picture is recomposed even when nothing was rendered.
+        if (redraw || profiler.overlay) {
             SDL_RenderClear(renderer);
             SDL_RenderCopy(renderer, texture, nullptr, nullptr);
             SDL_SetRenderDrawColor(renderer, FILL_INTENSITY, FILL_INTENSITY, FILL_INTENSITY, 255);
-            roots[0].x = coords_to_pix_x(a.real(), left, unit_width) - 5.0;
-            roots[0].y = coords_to_pix_y(a.imag(), top, unit_height) - 5.0;
-            roots[1].x = coords_to_pix_x(b.real(), left, unit_width) - 5.0;
-            roots[1].y = coords_to_pix_y(b.imag(), top, unit_height) - 5.0;
-            roots[2].x = coords_to_pix_x(c.real(), left, unit_width) - 5.0;
-            roots[2].y = coords_to_pix_y(c.imag(), top, unit_height) - 5.0;
-            SDL_RenderDrawRectsF(renderer, roots, 3);
-            changed = false;
+            for (size_t i = 0; i < root_count; ++i) {
+                markers[i].x = static_cast<float>(coords_to_pix_x(roots[i].real(), left, unit_width, window_width) - 5.0);
+                markers[i].y = static_cast<float>(coords_to_pix_y(roots[i].imag(), top, unit_height, window_height) - 5.0);
+            }
+            SDL_RenderDrawRectsF(renderer, markers, static_cast<int>(root_count));
+            if (profiler.overlay) profiler.draw(renderer, window_height);
+            const double present_start = profiler.now();
+            SDL_RenderPresent(renderer);
+            if (profiler.active()) profiler.host_stage(Stage::Present, present_start);
+            ++frame_count;
         }
-        SDL_RenderPresent(renderer);
+        if (profiler.active()) profiler.end_frame();
+        scheduler.end_frame(redraw || profiler.overlay, changed || block > 1 || shown_warm
+            || (pipeline && pipeline->in_flight() > 0));
         const uint32_t this_time = SDL_GetTicks();
-        ++frame_count;
         if (this_time - last_time >= 5000) {
             last_time = this_time;
-            std::cout << "FPS: " << frame_count / 5 << std::endl;
+            std::cout << "FPS: " << frame_count / 5 << ", pass 1/" << block;
+            if (pipeline) {
+                std::cout << ", " << pipeline->in_flight() << " in flight, " << pipeline->dropped << " dropped";
+                pipeline->dropped = 0;
+            }
+            if (governed) std::cout << ", iterations " << governor.budget(iteration_count) << "/" << iteration_count;
+            if (profiler.active()) {
+                for (const Stage stage : { Stage::Kernels, Stage::Transfers, Stage::Upload, Stage::Present })
+                    std::cout << ", " << stage_name(stage) << " " << profiler.mean(stage) << " ms";
+            }
+            if (engine == Engine::Tiled) {
+                std::cout << ", tiles " << context.tiles.hits << " hit / " << context.tiles.misses << " miss";
+                context.tiles.hits = context.tiles.misses = 0;
+            }
+            std::cout << std::endl;
             frame_count = 0;
         }
     }